@@ -0,0 +1,77 @@
+#ifndef ASTEROID_BELT_H
+#define ASTEROID_BELT_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "BodyInstances.h"
+
+// Main belt between mars and jupiter. Rocks only move on circular orbits and spin,
+// they are not CelestialBodies (no picking, trails or grid entries).
+class AsteroidBelt {
+public:
+    AsteroidBelt(unsigned int count, float innerRadius, float outerRadius, float thickness,
+                 float referenceRadius, float referenceSpeed, uint32_t seed = 7u) {
+        uint32_t state = seed ? seed : 1u;
+        auto random = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state & 0xFFFFFF) / 16777216.0f;
+        };
+
+        rocks.resize(count);
+        for (auto& rock : rocks) {
+            rock.radius = innerRadius + random() * (outerRadius - innerRadius);
+            rock.angle = random() * 6.2831853f;
+            rock.height = (random() - 0.5f) * thickness;
+            // kepler's third law relative to a known planet: speed ~ r^-1.5
+            rock.speed = referenceSpeed * powf(referenceRadius / rock.radius, 1.5f);
+            rock.size = 0.15f + random() * 0.45f;
+            rock.spin = random() * 6.2831853f;
+            rock.spinSpeed = 0.5f + random() * 2.0f;
+            glm::vec3 axis(random() - 0.5f, random() - 0.5f, random() - 0.5f);
+            rock.axis = glm::length(axis) > 0.001f ? glm::normalize(axis) : glm::vec3(0.0f, 1.0f, 0.0f);
+            float shade = 0.35f + random() * 0.3f;
+            rock.color = glm::vec3(shade, shade * 0.92f, shade * 0.85f);
+        }
+    }
+
+    void update(float deltaTime) {
+        for (auto& rock : rocks) {
+            rock.angle += rock.speed * deltaTime;
+            rock.spin += rock.spinSpeed * deltaTime;
+        }
+    }
+
+    glm::vec3 getPosition(size_t i) const {
+        const Rock& rock = rocks[i];
+        return glm::vec3(rock.radius * cos(rock.angle), rock.height, rock.radius * sin(rock.angle));
+    }
+
+    float getSize(size_t i) const { return rocks[i].size; }
+
+    void addInstance(BodyInstanceRenderer& renderer, size_t i, int surfaceLayer, int level = 0) const {
+        const Rock& rock = rocks[i];
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), getPosition(i));
+        model = glm::rotate(model, rock.spin, rock.axis);
+        model = glm::scale(model, glm::vec3(rock.size));
+        renderer.add(model, rock.color, surfaceLayer, false, false, -1, level);
+    }
+
+    size_t getCount() const { return rocks.size(); }
+
+private:
+    struct Rock {
+        float radius, angle, height, speed;
+        float size, spin, spinSpeed;
+        glm::vec3 axis;
+        glm::vec3 color;
+    };
+
+    std::vector<Rock> rocks;
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef BLOOM_CHAIN_H
+#define BLOOM_CHAIN_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <glm/glm.hpp>
+#include "ShaderProgram.h"
+#include "RenderTargetPool.h"
+
+// Bloom as a chain of half, quarter, ... resolution RGBA16F targets. The first downsample
+// keeps only what is over the threshold, each further one halves the previous level, then
+// the chain is walked back up with every level's upsample added onto the next larger one.
+// The half resolution level ends up holding the glow at every radius; wide glows come from the
+// small levels, so there are no full resolution blur passes at all.
+// All passes can be limited to a region of the scene (the sun's rectangle plus getReach());
+// outside it the chain stays black, only what the previous frame's region touched is cleared.
+// A scene rendered at reduced resolution fills only the lower left of its texture; every
+// level then uses the same fraction of its own texture.
+// The half resolution result is handed in by the caller (the frame graph, which keeps it
+// until the composite has read it); the smaller levels come from the render target pool for
+// the length of render(). A level that got a texture someone else wrote in between is
+// cleared in full, and so is one whose texture name may have been deleted by the pool and
+// handed out again for a new texture.
+class BloomChain {
+public:
+    static const int MAX_LEVELS = 6;
+    static const int MIN_SIZE = 8;    // stop halving once a side would drop below this
+
+    float threshold;   // scene luminance where the glow starts
+    float knee;        // soft ramp below the threshold
+
+    BloomChain() : threshold(1.5f), knee(0.5f), width(0), height(0), pool(nullptr), downsample(nullptr),
+                   upsample(nullptr), dirty(0), region(0), scene(0) {}
+
+    void init(int width, int height, RenderTargetPool& pool, ShaderProgram& downsample, ShaderProgram& upsample) {
+        this->pool = &pool;
+        this->downsample = &downsample;
+        this->upsample = &upsample;
+        prefilter = downsample.param("prefilter");
+        thresholdParam = downsample.param("threshold");
+        kneeParam = downsample.param("knee");
+        downsampleScale = downsample.param("sourceScale");
+        upsampleScale = upsample.param("sourceScale");
+
+        glUseProgram(downsample.id);
+        downsample.set(downsample.param("source"), 0);
+        glUseProgram(upsample.id);
+        upsample.set(upsample.param("source"), 0);
+        glUseProgram(0);
+
+        resize(width, height);
+    }
+
+    // level sizes for a scene of this size; textures of the old size are left to the pool
+    void resize(int width, int height) {
+        this->width = width;
+        this->height = height;
+        scene = glm::ivec2(width, height);
+
+        size_t count = 0;
+        int w = width / 2, h = height / 2;
+        while ((int)count < MAX_LEVELS && w >= MIN_SIZE && h >= MIN_SIZE) {
+            if (count == levels.size()) {
+                Level level;
+                glGenFramebuffers(1, &level.FBO);
+                levels.push_back(level);
+            }
+            Level& level = levels[count++];
+            level.width = w;
+            level.height = h;
+            level.texture = 0;
+            level.attached = 0;
+            level.acquisitions = 0;
+            level.allocations = 0;
+            w /= 2;
+            h /= 2;
+        }
+        while (levels.size() > count) {
+            glDeleteFramebuffers(1, &levels.back().FBO);
+            levels.pop_back();
+        }
+    }
+
+    void destroy() {
+        for (auto& level : levels)
+            glDeleteFramebuffers(1, &level.FBO);
+        levels.clear();
+    }
+
+    // blurs what is over the threshold inside area (scene pixels x, y, width, height) of the
+    // sceneSize pixels in use in sceneTexture into result, an RGBA16F target of getResultSize();
+    // leaves the default framebuffer bound with a full size viewport, blending and scissoring off
+    void render(GLuint sceneTexture, GLuint quadVAO, const glm::ivec4& area, const glm::ivec2& sceneSize,
+                const RenderTargetPool::Target& result) {
+        if (levels.empty())
+            return;
+        glBindVertexArray(quadVAO);
+        glActiveTexture(GL_TEXTURE0);
+        glDisable(GL_BLEND);
+        glEnable(GL_SCISSOR_TEST);
+
+        // black out last frame's glow, the passes below only write inside the new region
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        for (size_t i = 0; i < levels.size(); i++) {
+            Level& level = levels[i];
+            RenderTargetPool::Target target = i == 0 ? result : pool->acquire(GL_RGBA16F, level.width, level.height);
+            // same name after a new allocation can be a recycled name on a different texture
+            bool reallocated = level.allocations != pool->getAllocations();
+            bool intact = !reallocated && target.texture == level.attached && target.acquisitions == level.acquisitions + 1;
+            level.texture = target.texture;
+            level.acquisitions = target.acquisitions;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, level.FBO);
+            if (level.attached != level.texture || reallocated) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+                level.attached = level.texture;
+                level.allocations = pool->getAllocations();
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                    std::cout << "Bloom framebuffer error at " << level.width << "x" << level.height << std::endl;
+            }
+            if (intact)
+                scissor(level, (int)i, dirty);
+            else
+                glScissor(0, 0, level.width, level.height);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        scene = glm::ivec2(glm::min(sceneSize.x, width), glm::min(sceneSize.y, height));
+        region = glm::ivec4(glm::max(area.x, 0), glm::max(area.y, 0), 0, 0);
+        region.z = glm::max(glm::min(area.x + area.z, scene.x) - region.x, 0);
+        region.w = glm::max(glm::min(area.y + area.w, scene.y) - region.y, 0);
+        dirty = region;
+
+        glUseProgram(downsample->id);
+        downsample->set(thresholdParam, threshold);
+        downsample->set(kneeParam, knee);
+        downsample->set(downsampleScale, glm::vec2(scene) / glm::vec2((float)width, (float)height));
+        GLuint source = sceneTexture;
+        for (size_t i = 0; i < levels.size(); i++) {
+            if (i > 0)
+                downsample->set(downsampleScale, getScale((int)i - 1));
+            downsample->set(prefilter, i == 0);
+            drawInto(levels[i], (int)i, source);
+            source = levels[i].texture;
+        }
+
+        glUseProgram(upsample->id);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (size_t i = levels.size() - 1; i > 0; i--) {
+            upsample->set(upsampleScale, getScale((int)i));
+            drawInto(levels[i - 1], (int)i - 1, levels[i].texture);
+        }
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+
+        // only the result is still needed, and that one belongs to the caller
+        for (size_t i = 0; i < levels.size(); i++) {
+            if (i > 0)
+                pool->release(levels[i].texture);
+            levels[i].texture = 0;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, width, height);
+    }
+
+    // size of the target render() blurs into, half the scene's resolution
+    glm::ivec2 getResultSize() const {
+        return levels.empty() ? glm::ivec2(MIN_SIZE) : glm::ivec2(levels[0].width, levels[0].height);
+    }
+
+    // fraction of a level's texture covered by the scene rendered last
+    glm::vec2 getScale(int level = 0) const {
+        if (levels.empty())
+            return glm::vec2(1.0f);
+        return glm::vec2(activeSize(level)) / glm::vec2((float)levels[level].width, (float)levels[level].height);
+    }
+    int getLevelCount() const { return (int)levels.size(); }
+
+    // how far (scene pixels) the glow spreads from a bright pixel: each level's passes reach a
+    // couple of its texels, so the smallest level dominates
+    int getReach() const { return levels.empty() ? 0 : 5 << levels.size(); }
+
+    // region processed by the last render(), for the debug panel
+    const glm::ivec4& getRegion() const { return region; }
+
+private:
+    struct Level {
+        GLuint FBO;
+        GLuint texture;              // held during render(), 0 outside it
+        GLuint attached;             // what FBO currently points at
+        unsigned int acquisitions;   // of that texture when this level last held it
+        unsigned int allocations;    // pool's allocation count when it was attached
+        int width, height;
+    };
+
+    std::vector<Level> levels;
+    int width, height;
+    RenderTargetPool* pool;
+    ShaderProgram* downsample;
+    ShaderProgram* upsample;
+    int prefilter, thresholdParam, kneeParam;
+    glm::ivec4 dirty;    // scene pixels that may still hold glow
+    glm::ivec4 region;
+    glm::ivec2 scene;    // scene pixels in use, the rest of the texture is stale
+    int downsampleScale, upsampleScale;
+
+    glm::ivec2 activeSize(int index) const {
+        int scale = 2 << index;
+        return glm::ivec2(glm::min((scene.x + scale - 1) / scale, levels[index].width),
+                          glm::min((scene.y + scale - 1) / scale, levels[index].height));
+    }
+
+    // a scene rectangle in level texels, rounded outwards
+    void scissor(const Level& level, int index, const glm::ivec4& rect) {
+        int scale = 2 << index;
+        int x0 = rect.x / scale, y0 = rect.y / scale;
+        int x1 = (rect.x + rect.z + scale - 1) / scale + 1;
+        int y1 = (rect.y + rect.w + scale - 1) / scale + 1;
+        x0 = x0 > 0 ? x0 - 1 : 0;
+        y0 = y0 > 0 ? y0 - 1 : 0;
+        glScissor(x0, y0, glm::max(glm::min(x1, level.width) - x0, 0), glm::max(glm::min(y1, level.height) - y0, 0));
+    }
+
+    void drawInto(const Level& level, int index, GLuint source) {
+        glBindFramebuffer(GL_FRAMEBUFFER, level.FBO);
+        glm::ivec2 size = activeSize(index);
+        glViewport(0, 0, size.x, size.y);
+        scissor(level, index, region);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+};
+
+#endif
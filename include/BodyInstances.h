@@ -0,0 +1,190 @@
+#ifndef BODY_INSTANCES_H
+#define BODY_INSTANCES_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "SphereLOD.h"
+
+// Per-instance data for the sphere path, matches attributes 3-8 of body_instanced_vertex.glsl.
+struct BodyInstance {
+    glm::mat4 model;
+    glm::vec4 color;   // rgb, surface layer in the texture array (-1 = untextured)
+    glm::vec4 flags;   // isSun, isSelected, night lights layer (-1 = none), unused
+};
+
+inline BodyInstance makeBodyInstance(const glm::mat4& model, const glm::vec3& color, int layer,
+                                     bool isSun = false, bool isSelected = false, int nightLayer = -1) {
+    BodyInstance instance;
+    instance.model = model;
+    instance.color = glm::vec4(color, (float)layer);
+    instance.flags = glm::vec4(isSun ? 1.0f : 0.0f, isSelected ? 1.0f : 0.0f, (float)nightLayer, 0.0f);
+    return instance;
+}
+
+// Draws every sphere in the scene (planets, moons, asteroids) with one glDrawElementsInstanced
+// per detail level. Shares the LOD vertex and index buffers; instances are grouped by level and
+// the instance buffer is refilled each frame. GL 3.3 has no baseInstance, so draw() moves the
+// instance attribute pointers to each level's slice before drawing it.
+// One extra bucket past the mesh levels holds impostors: a camera-facing quad per instance that
+// body_impostor_vertex.glsl sizes to the sphere and the IMPOSTOR fragment variant ray traces.
+class BodyInstanceRenderer {
+public:
+    BodyInstanceRenderer() : VAO(0), impostorVAO(0), instanceVBO(0), cornerVBO(0), capacity(0) {}
+
+    void init(GLuint meshVBO, GLuint meshEBO, const SphereLOD& lod, unsigned int initialCapacity = 256) {
+        levels = lod.levels;
+        buckets.assign(levels.size() + 1, std::vector<BodyInstance>());
+        levelStart.assign(levels.size() + 1, 0);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceVBO);
+        glBindVertexArray(VAO);
+
+        // sphere vertices: packed position, uv
+        glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+        setupPackedVertexAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+
+        // per-instance: mat4 takes four vec4 slots, then color and flags
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (int i = 0; i < 6; i++) {
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        pointInstances(0);
+
+        // impostor quad: corners in [-1, 1], drawn as a strip
+        float corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+        glGenVertexArrays(1, &impostorVAO);
+        glGenBuffers(1, &cornerVBO);
+        glBindVertexArray(impostorVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, cornerVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (int i = 0; i < 6; i++) {
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        pointInstances(0);
+        glBindVertexArray(0);
+
+        reserve(initialCapacity);
+    }
+
+    void destroy() {
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteVertexArrays(1, &impostorVAO);
+            glDeleteBuffers(1, &instanceVBO);
+            glDeleteBuffers(1, &cornerVBO);
+            VAO = 0;
+        }
+    }
+
+    // bucket for add() that draws as a ray-traced quad instead of a mesh
+    int getImpostorLevel() const { return (int)levels.size(); }
+
+    void begin() {
+        for (auto& bucket : buckets)
+            bucket.clear();
+        instances.clear();
+    }
+
+    void add(const glm::mat4& model, const glm::vec3& color, int layer,
+             bool isSun = false, bool isSelected = false, int nightLayer = -1, int level = 0) {
+        buckets[level].push_back(makeBodyInstance(model, color, layer, isSun, isSelected, nightLayer));
+    }
+
+    // packs impostors then the mesh levels back to back and uploads them in one go;
+    // the indirect path draws the meshes itself and only needs the impostors here
+    void upload(bool meshLevels = true) {
+        size_t impostors = levels.size();
+        levelStart[impostors] = 0;
+        instances.insert(instances.end(), buckets[impostors].begin(), buckets[impostors].end());
+        for (size_t level = 0; meshLevels && level < levels.size(); level++) {
+            levelStart[level] = (unsigned int)instances.size();
+            instances.insert(instances.end(), buckets[level].begin(), buckets[level].end());
+        }
+        if (instances.empty())
+            return;
+        if (instances.size() > capacity)
+            reserve((unsigned int)instances.size() * 2);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(BodyInstance), NULL, GL_STREAM_DRAW);   // orphan
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(BodyInstance), instances.data());
+    }
+
+    void draw() {
+        if (instances.empty())
+            return;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (size_t level = 0; level < levels.size(); level++) {
+            if (buckets[level].empty())
+                continue;
+            pointInstances(levelStart[level]);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, levels[level].indexCount, GL_UNSIGNED_SHORT,
+                                              (void*)(levels[level].firstIndex * sizeof(uint16_t)),
+                                              (GLsizei)buckets[level].size(), levels[level].baseVertex);
+        }
+        glBindVertexArray(0);
+    }
+
+    void drawImpostors() {
+        size_t count = buckets[levels.size()].size();
+        if (count == 0)
+            return;
+        glBindVertexArray(impostorVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        pointInstances(levelStart[levels.size()]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+        glBindVertexArray(0);
+    }
+
+    size_t getCount() const {
+        size_t count = 0;
+        for (const auto& bucket : buckets)
+            count += bucket.size();
+        return count;
+    }
+    size_t getLevelCount(int level) const { return buckets[level].size(); }
+    unsigned int getLevelRings(int level) const { return levels[level].rings; }
+    const std::vector<BodyInstance>& getInstances(int level) const { return buckets[level]; }
+
+    // triangles submitted by the last draw
+    size_t getTriangleCount() const {
+        size_t triangles = 0;
+        for (size_t level = 0; level < levels.size(); level++)
+            triangles += buckets[level].size() * (levels[level].indexCount / 3);
+        return triangles + buckets[levels.size()].size() * 2;
+    }
+
+private:
+    GLuint VAO, impostorVAO, instanceVBO, cornerVBO;
+    unsigned int capacity;
+    std::vector<SphereLOD::Level> levels;
+    std::vector<std::vector<BodyInstance>> buckets;
+    std::vector<unsigned int> levelStart;
+    std::vector<BodyInstance> instances;
+
+    // instance attributes of the bound VAO start at the given instance (expects the instance VBO bound)
+    void pointInstances(unsigned int first) {
+        size_t base = first * sizeof(BodyInstance);
+        for (int i = 0; i < 6; i++) {
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)(base + i * 4 * sizeof(float)));
+        }
+    }
+
+    void reserve(unsigned int newCapacity) {
+        capacity = newCapacity > 0 ? newCapacity : 1;
+        instances.reserve(capacity);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(BodyInstance), NULL, GL_STREAM_DRAW);
+    }
+};
+
+#endif
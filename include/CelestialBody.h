@@ -24,8 +24,9 @@ public:
     float orbitSpeed;        // orbit speed
     float orbitAngle;        // current angle
     
-    // Texture
-    unsigned int textureID;
+    // Texture (layers in the surface texture array, -1 = none)
+    int textureLayer;
+    int nightLayer;          // city lights on the dark side
     bool hasTexture;
     
     // Info panel texture (for sidebar display)
@@ -37,6 +38,9 @@ public:
     float ringInnerRadius;
     float ringOuterRadius;
     unsigned int ringTextureID;
+    
+    // Traversed-path trail (number of points, 0 = no trail)
+    unsigned int trailLength;
 
     CelestialBody(const std::string& name, float mass, float radius, float displayRadius,
                   const glm::vec3& position, const glm::vec3& velocity, 
@@ -45,8 +49,9 @@ public:
           position(position), velocity(velocity), color(color), 
           rotationSpeed(rotationSpeed), rotationAngle(0.0f), isSun(isSun),
           orbitRadius(glm::length(position)), orbitSpeed(velocity.z), orbitAngle(0.0f),
-          textureID(0), hasTexture(false), infoTextureID(0), hasInfoTexture(false),
-          hasRing(false), ringInnerRadius(0.0f), ringOuterRadius(0.0f), ringTextureID(0) {}
+          textureLayer(-1), nightLayer(-1), hasTexture(false), infoTextureID(0), hasInfoTexture(false),
+          hasRing(false), ringInnerRadius(0.0f), ringOuterRadius(0.0f), ringTextureID(0),
+          trailLength(0) {}
 
     void update(float deltaTime, const std::vector<CelestialBody*>& bodies) {
         if (isSun) {
@@ -0,0 +1,369 @@
+#ifndef COMET_H
+#define COMET_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMET_SSE2 1
+#endif
+
+// Fixed-capacity particle pool.
+// Particles are stored as structure-of-arrays so the update runs 4 at a time,
+// dead slots go back on a free list, nothing is allocated after construction.
+class ParticlePool {
+public:
+    unsigned int capacity;
+    unsigned int aliveCount;
+
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> age, life;   // life == FLT_MAX marks a free slot
+
+    ParticlePool(unsigned int requestedCapacity)
+        : capacity((requestedCapacity + 3) & ~3u), aliveCount(0)
+    {
+        posX.assign(capacity, 0.0f); posY.assign(capacity, 0.0f); posZ.assign(capacity, 0.0f);
+        velX.assign(capacity, 0.0f); velY.assign(capacity, 0.0f); velZ.assign(capacity, 0.0f);
+        age.assign(capacity, 0.0f);
+        life.assign(capacity, FLT_MAX);
+
+        freeList.reserve(capacity);
+        for (int i = (int)capacity - 1; i >= 0; i--) {
+            freeList.push_back(i);
+        }
+    }
+
+    // returns false when the pool is exhausted
+    bool spawn(const glm::vec3& position, const glm::vec3& velocity, float lifetime) {
+        if (freeList.empty())
+            return false;
+        int i = freeList.back();
+        freeList.pop_back();
+
+        posX[i] = position.x; posY[i] = position.y; posZ[i] = position.z;
+        velX[i] = velocity.x; velY[i] = velocity.y; velZ[i] = velocity.z;
+        age[i] = 0.0f;
+        life[i] = lifetime;
+        aliveCount++;
+        return true;
+    }
+
+    // integrates every slot; accel = repulsion * (p - center) / |p - center|^3 pushes away from
+    // the sun (negative attracts). Returns the largest squared distance of a live particle from origin.
+    float update(float deltaTime, const glm::vec3& center, float repulsion, const glm::vec3& origin) {
+        unsigned int i = 0;
+        float maxDistance2 = 0.0f;
+#ifdef COMET_SSE2
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        const __m128 cx = _mm_set1_ps(center.x);
+        const __m128 cy = _mm_set1_ps(center.y);
+        const __m128 cz = _mm_set1_ps(center.z);
+        const __m128 k = _mm_set1_ps(repulsion * deltaTime);
+        const __m128 eps = _mm_set1_ps(1.0f);
+        const __m128 ox = _mm_set1_ps(origin.x);
+        const __m128 oy = _mm_set1_ps(origin.y);
+        const __m128 oz = _mm_set1_ps(origin.z);
+        const __m128 freeSlot = _mm_set1_ps(FLT_MAX);
+        __m128 farthest = _mm_setzero_ps();
+        for (; i < capacity; i += 4) {
+            __m128 px = _mm_loadu_ps(&posX[i]), py = _mm_loadu_ps(&posY[i]), pz = _mm_loadu_ps(&posZ[i]);
+            __m128 vx = _mm_loadu_ps(&velX[i]), vy = _mm_loadu_ps(&velY[i]), vz = _mm_loadu_ps(&velZ[i]);
+
+            if (repulsion != 0.0f) {
+                __m128 dx = _mm_sub_ps(px, cx), dy = _mm_sub_ps(py, cy), dz = _mm_sub_ps(pz, cz);
+                __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                       _mm_add_ps(_mm_mul_ps(dz, dz), eps));
+                __m128 invR = _mm_rsqrt_ps(r2);
+                __m128 a = _mm_mul_ps(k, _mm_mul_ps(invR, _mm_mul_ps(invR, invR)));
+                vx = _mm_add_ps(vx, _mm_mul_ps(dx, a));
+                vy = _mm_add_ps(vy, _mm_mul_ps(dy, a));
+                vz = _mm_add_ps(vz, _mm_mul_ps(dz, a));
+                _mm_storeu_ps(&velX[i], vx); _mm_storeu_ps(&velY[i], vy); _mm_storeu_ps(&velZ[i], vz);
+            }
+
+            px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+            py = _mm_add_ps(py, _mm_mul_ps(vy, dt));
+            pz = _mm_add_ps(pz, _mm_mul_ps(vz, dt));
+            _mm_storeu_ps(&posX[i], px);
+            _mm_storeu_ps(&posY[i], py);
+            _mm_storeu_ps(&posZ[i], pz);
+
+            // free slots drift too, only live lanes count for the extent
+            __m128 ex = _mm_sub_ps(px, ox), ey = _mm_sub_ps(py, oy), ez = _mm_sub_ps(pz, oz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+            __m128 l4 = _mm_loadu_ps(&life[i]);
+            farthest = _mm_max_ps(farthest, _mm_and_ps(_mm_cmplt_ps(l4, freeSlot), d2));
+
+            __m128 a4 = _mm_add_ps(_mm_loadu_ps(&age[i]), dt);
+            _mm_storeu_ps(&age[i], a4);
+
+            // recycle the lanes that just expired
+            int expired = _mm_movemask_ps(_mm_cmpge_ps(a4, l4));
+            if (expired) {
+                for (int lane = 0; lane < 4; lane++) {
+                    if (expired & (1 << lane))
+                        release(i + lane);
+                }
+            }
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, farthest);
+        maxDistance2 = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#else
+        for (; i < capacity; i++) {
+            if (repulsion != 0.0f) {
+                glm::vec3 d(posX[i] - center.x, posY[i] - center.y, posZ[i] - center.z);
+                float r2 = glm::dot(d, d) + 1.0f;
+                float a = repulsion * deltaTime / (r2 * sqrt(r2));
+                velX[i] += d.x * a; velY[i] += d.y * a; velZ[i] += d.z * a;
+            }
+            posX[i] += velX[i] * deltaTime;
+            posY[i] += velY[i] * deltaTime;
+            posZ[i] += velZ[i] * deltaTime;
+            if (life[i] != FLT_MAX) {
+                glm::vec3 e(posX[i] - origin.x, posY[i] - origin.y, posZ[i] - origin.z);
+                maxDistance2 = std::max(maxDistance2, glm::dot(e, e));
+            }
+            age[i] += deltaTime;
+            if (age[i] >= life[i])
+                release(i);
+        }
+#endif
+        return maxDistance2;
+    }
+
+    // writes alive particles as (x, y, z, age / life), returns the count written
+    unsigned int gather(float* out) const {
+        unsigned int n = 0;
+        for (unsigned int i = 0; i < capacity; i++) {
+            if (life[i] == FLT_MAX)
+                continue;
+            out[n * 4 + 0] = posX[i];
+            out[n * 4 + 1] = posY[i];
+            out[n * 4 + 2] = posZ[i];
+            out[n * 4 + 3] = age[i] / life[i];
+            n++;
+        }
+        return n;
+    }
+
+private:
+    std::vector<int> freeList;
+
+    void release(unsigned int i) {
+        life[i] = FLT_MAX;
+        age[i] = 0.0f;
+        freeList.push_back(i);
+        aliveCount--;
+    }
+};
+
+// Comet on a keplerian ellipse around the sun, emitting a curved dust tail
+// and a straight ion tail. Both tails share one instance buffer and are drawn
+// with a single instanced call (dust first, ion after ionStart).
+class Comet {
+public:
+    // orbital elements (angles in radians, distances in scene units)
+    float semiMajorAxis;
+    float eccentricity;
+    float inclination;
+    float ascendingNode;
+    float argPeriapsis;
+    float meanAnomaly;
+    float meanMotion;       // rad/s
+
+    glm::vec3 position;
+    glm::vec3 velocity;
+
+    // activity grows with 1 / r^2 inside activityRadius
+    float activityRadius;
+    float referenceRadius;  // distance where the base rates apply
+    float dustRate;         // particles/s at referenceRadius
+    float ionRate;
+    float dustLifetime;
+    float ionLifetime;
+    float ionSpeed;
+    float radiationPressure;  // outward push on dust, against the sun's pull
+
+    ParticlePool dust;
+    ParticlePool ions;
+
+    Comet(float semiMajorAxis, float eccentricity, float inclination,
+          float ascendingNode, float argPeriapsis, float meanAnomaly, uint32_t seed,
+          unsigned int dustCapacity = 4096, unsigned int ionCapacity = 2048)
+        : semiMajorAxis(semiMajorAxis), eccentricity(eccentricity), inclination(inclination),
+          ascendingNode(ascendingNode), argPeriapsis(argPeriapsis), meanAnomaly(meanAnomaly),
+          // visual kepler's third law, tuned so a = 100 matches earth's orbit speed
+          meanMotion(1.3f * std::pow(semiMajorAxis / 100.0f, -1.5f)),
+          activityRadius(250.0f), referenceRadius(60.0f),
+          dustRate(600.0f), ionRate(500.0f), dustLifetime(6.0f), ionLifetime(3.0f),
+          ionSpeed(25.0f), radiationPressure(2000.0f),
+          dust(dustCapacity), ions(ionCapacity),
+          VAO(0), instanceVBO(0), rngState(seed ? seed : 1u),
+          dustAccumulator(0.0f), ionAccumulator(0.0f), tailExtent(0.0f), ionStart(0), instanceCount(0)
+    {
+        position = orbitPosition(meanAnomaly);
+        velocity = glm::vec3(0.0f);
+        instanceData.resize((dust.capacity + ions.capacity) * 4);
+    }
+
+    // quadVBO holds the 4 corners of a unit billboard (triangle strip)
+    void init(GLuint quadVBO) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceVBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(float), NULL, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+
+        glBindVertexArray(0);
+    }
+
+    void destroy() {
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &instanceVBO);
+            VAO = 0;
+        }
+    }
+
+    void update(float deltaTime, const glm::vec3& sunPos) {
+        if (deltaTime <= 0.0f)
+            return;
+
+        // move along the orbit
+        meanAnomaly = fmod(meanAnomaly + meanMotion * deltaTime, 6.28318530718f);
+        glm::vec3 newPosition = sunPos + orbitPosition(meanAnomaly);
+        velocity = (newPosition - position) / deltaTime;
+        position = newPosition;
+
+        // outgassing scales with 1 / r^2 from the sun
+        glm::vec3 fromSun = position - sunPos;
+        float distance = glm::length(fromSun);
+        glm::vec3 antiSun = fromSun / std::max(distance, 0.001f);
+        float activity = 0.0f;
+        if (distance < activityRadius) {
+            float ratio = referenceRadius / distance;
+            activity = std::min(ratio * ratio, 4.0f);
+        }
+
+        dustAccumulator += dustRate * activity * deltaTime;
+        while (dustAccumulator >= 1.0f) {
+            glm::vec3 jitter = randomDirection() * 0.6f;
+            if (!dust.spawn(position + jitter * 0.3f, velocity + antiSun * 1.5f + jitter, dustLifetime * (0.7f + 0.6f * random()))) {
+                dustAccumulator = 0.0f;  // pool full, drop the backlog
+                break;
+            }
+            dustAccumulator -= 1.0f;
+        }
+
+        ionAccumulator += ionRate * activity * deltaTime;
+        while (ionAccumulator >= 1.0f) {
+            glm::vec3 jitter = randomDirection() * 0.8f;
+            if (!ions.spawn(position + jitter * 0.2f, antiSun * ionSpeed + jitter, ionLifetime * (0.7f + 0.6f * random()))) {
+                ionAccumulator = 0.0f;
+                break;
+            }
+            ionAccumulator -= 1.0f;
+        }
+
+        // dust falls around the sun like the comet does, less the radiation push, and curves
+        // away from its orbit; ions fly straight out. The orbit's own GM (n^2 a^3) keeps dust
+        // on matching paths, substeps keep it stable at perihelion speeds
+        float gm = meanMotion * meanMotion * semiMajorAxis * semiMajorAxis * semiMajorAxis;
+        int substeps = (int)std::ceil(glm::length(velocity) * deltaTime / (0.05f * std::max(distance, 1.0f)));
+        substeps = std::min(std::max(substeps, 1), 8);
+        float dustExtent2 = 0.0f;
+        for (int step = 0; step < substeps; step++)
+            dustExtent2 = dust.update(deltaTime / substeps, sunPos, radiationPressure - gm, position);
+        float ionExtent2 = ions.update(deltaTime, sunPos, 0.0f, position);
+        tailExtent = std::sqrt(std::max(dustExtent2, ionExtent2));
+    }
+
+    // packs both tails into the instance buffer (dust first, then ions)
+    void upload() {
+        ionStart = dust.gather(instanceData.data());
+        instanceCount = ionStart + ions.gather(instanceData.data() + ionStart * 4);
+        if (instanceCount == 0)
+            return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * 4 * sizeof(float), instanceData.data());
+    }
+
+    // single instanced draw for both tails, call after upload()
+    void draw() {
+        if (instanceCount == 0)
+            return;
+
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+        glBindVertexArray(0);
+    }
+
+    // sphere around the nucleus that holds both tails, from where the particles actually are
+    // after the last update, plus a particle's size
+    float getBoundingRadius() const { return tailExtent + 1.0f; }
+
+    unsigned int getIonStart() const { return ionStart; }
+    unsigned int getParticleCount() const { return dust.aliveCount + ions.aliveCount; }
+
+    glm::vec3 orbitPosition(float M) const {
+        // solve kepler's equation E - e sin E = M with a few newton steps
+        float E = eccentricity > 0.8f ? 3.14159265359f : M;
+        for (int i = 0; i < 8; i++) {
+            E -= (E - eccentricity * sin(E) - M) / (1.0f - eccentricity * cos(E));
+        }
+
+        // position in the orbital plane, perihelion along +x
+        float x = semiMajorAxis * (cos(E) - eccentricity);
+        float y = semiMajorAxis * sqrt(1.0f - eccentricity * eccentricity) * sin(E);
+
+        // rotate by argument of periapsis, inclination and ascending node (y is up in the scene)
+        float cw = cos(argPeriapsis), sw = sin(argPeriapsis);
+        float ci = cos(inclination), si = sin(inclination);
+        float cn = cos(ascendingNode), sn = sin(ascendingNode);
+
+        float xp = x * cw - y * sw;
+        float yp = x * sw + y * cw;
+        glm::vec3 p(xp, yp * si, yp * ci);
+        return glm::vec3(p.x * cn - p.z * sn, p.y, p.x * sn + p.z * cn);
+    }
+
+private:
+    GLuint VAO, instanceVBO;
+    uint32_t rngState;
+    float dustAccumulator, ionAccumulator;
+    float tailExtent;   // farthest live particle from the nucleus
+    unsigned int ionStart, instanceCount;
+    std::vector<float> instanceData;
+
+    float random() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return (rngState & 0xFFFFFF) / 16777216.0f;
+    }
+
+    glm::vec3 randomDirection() {
+        glm::vec3 d(random() * 2.0f - 1.0f, random() * 2.0f - 1.0f, random() * 2.0f - 1.0f);
+        float len = glm::length(d);
+        return len > 0.0001f ? d / len : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+};
+
+#endif
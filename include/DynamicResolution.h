@@ -0,0 +1,56 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <cmath>
+
+// Picks the fraction of the window's resolution the 3D scene renders at, from the GPU time of
+// the scaled part of the frame. Fill cost goes with pixel count, so the scale moves by the
+// square root of budget / measured time. GPU times arrive a few frames late and smoothed,
+// so the scale is only revisited every INTERVAL frames, moves in STEP increments, and only
+// grows once there is clear headroom, which keeps it from oscillating around the budget.
+class DynamicResolution {
+public:
+    static const int INTERVAL = 20;
+    static constexpr float STEP = 0.05f;
+
+    bool enabled;
+    float budgetMs;      // GPU time the scene, bloom and composite should fit in
+    float minScale, maxScale;
+
+    DynamicResolution() : enabled(true), budgetMs(14.0f), minScale(0.5f), maxScale(1.0f),
+                          scale(1.0f), frames(0) {}
+
+    // once per frame with the latest measured GPU time
+    void update(double gpuMs) {
+        if (!enabled) {
+            scale = maxScale;
+            return;
+        }
+        if (++frames < INTERVAL || gpuMs <= 0.0)
+            return;
+        frames = 0;
+
+        float target = scale;
+        if (gpuMs > budgetMs)
+            target = scale * sqrtf(budgetMs / (float)gpuMs);
+        else if (gpuMs < budgetMs * 0.75f)
+            target = scale * sqrtf(budgetMs * 0.85f / (float)gpuMs);
+
+        // at most two steps per revisit, rounded down to a step
+        float limit = STEP * 2.0f;
+        if (target > scale + limit)
+            target = scale + limit;
+        if (target < scale - limit)
+            target = scale - limit;
+        target = floorf(target / STEP + 0.001f) * STEP;
+        scale = target < minScale ? minScale : (target > maxScale ? maxScale : target);
+    }
+
+    float getScale() const { return scale; }
+
+private:
+    float scale;
+    int frames;
+};
+
+#endif
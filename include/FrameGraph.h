@@ -0,0 +1,245 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <string>
+#include <functional>
+#include <iostream>
+#include "RenderTargetPool.h"
+
+// The frame's GPU work as passes that declare which resources they read and write, rebuilt
+// every frame. compile() drops passes nothing depends on (working back from the outputs),
+// orders the rest so every resource is written before it is read, and works out when each
+// transient texture is first and last used. execute() acquires a transient from the pool
+// right before its first pass and releases it right after its last, so targets whose
+// lifetimes don't overlap share memory.
+// A resource's writers run in the order they were added, its readers after all of them.
+// GL orders framebuffer writes before later texture reads by itself, so there are no
+// explicit barriers to insert.
+class FrameGraph {
+public:
+    typedef std::function<void()> Execute;
+
+    explicit FrameGraph(RenderTargetPool& pool) : pool(pool), compiled(false), cycleReported(false) {}
+
+    // starts declaring a new frame
+    void reset() {
+        passes.clear();
+        resources.clear();
+        order.clear();
+        compiled = false;
+    }
+
+    // pool-backed texture that only lives between its first and last use this frame
+    int createTexture(const char* name, GLenum format, int width, int height) {
+        Resource r;
+        r.name = name;
+        r.transient = true;
+        r.format = format;
+        r.width = width;
+        r.height = height;
+        resources.push_back(r);
+        return (int)resources.size() - 1;
+    }
+
+    // something the graph doesn't allocate, like the default framebuffer
+    int importResource(const char* name) {
+        Resource r;
+        r.name = name;
+        resources.push_back(r);
+        return (int)resources.size() - 1;
+    }
+
+    // the frame exists to produce this; passes leading to it are never culled
+    void markOutput(int resource) { resources[resource].output = true; }
+
+    int addPass(const char* name, Execute execute) {
+        Pass p;
+        p.name = name;
+        p.execute = execute;
+        passes.push_back(p);
+        return (int)passes.size() - 1;
+    }
+
+    void read(int pass, int resource) {
+        passes[pass].reads.push_back(resource);
+        resources[resource].readers.push_back(pass);
+    }
+
+    void write(int pass, int resource) {
+        passes[pass].writes.push_back(resource);
+        resources[resource].writers.push_back(pass);
+    }
+
+    void compile() {
+        cull();
+        sort();
+
+        for (auto& r : resources) {
+            r.first = r.last = -1;
+        }
+        for (int i = 0; i < (int)order.size(); i++) {
+            const Pass& p = passes[order[i]];
+            for (int list = 0; list < 2; list++) {
+                for (int res : list == 0 ? p.reads : p.writes) {
+                    Resource& r = resources[res];
+                    if (r.first < 0)
+                        r.first = i;
+                    r.last = i;
+                }
+            }
+        }
+        compiled = true;
+    }
+
+    void execute() {
+        if (!compiled)
+            compile();
+        for (int i = 0; i < (int)order.size(); i++) {
+            for (auto& r : resources) {
+                if (r.transient && r.first == i)
+                    r.target = pool.acquire(r.format, r.width, r.height);
+            }
+            passes[order[i]].execute();
+            for (auto& r : resources) {
+                if (r.transient && r.last == i) {
+                    pool.release(r.target.texture);
+                    r.target.texture = 0;
+                }
+            }
+        }
+    }
+
+    // only valid while a pass using the resource executes
+    const RenderTargetPool::Target& getTarget(int resource) const { return resources[resource].target; }
+    GLuint getTexture(int resource) const { return resources[resource].target.texture; }
+
+    int getPassCount() const { return (int)passes.size(); }
+    int getExecutedCount() const { return (int)order.size(); }
+    bool isCulled(int pass) const { return passes[pass].culled; }
+
+    // executed passes in order, culled ones in brackets, for the debug panel
+    std::string describe() const {
+        std::string text;
+        for (int index : order) {
+            if (!text.empty())
+                text += " > ";
+            text += passes[index].name;
+        }
+        for (const auto& p : passes) {
+            if (p.culled)
+                text += " [" + p.name + "]";
+        }
+        return text;
+    }
+
+private:
+    struct Pass {
+        std::string name;
+        Execute execute;
+        std::vector<int> reads, writes;
+        int refCount = 0;
+        bool culled = false;
+    };
+
+    struct Resource {
+        std::string name;
+        bool transient = false;
+        bool output = false;
+        GLenum format = 0;
+        int width = 0, height = 0;
+        std::vector<int> readers, writers;
+        int refCount = 0;
+        int first = -1, last = -1;   // positions in order
+        RenderTargetPool::Target target = {};
+    };
+
+    RenderTargetPool& pool;
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<int> order;
+    bool compiled;
+    bool cycleReported;   // the graph is rebuilt every frame, say it once
+
+    // a pass survives while something still reads one of its writes
+    void cull() {
+        for (auto& p : passes) {
+            p.refCount = (int)p.writes.size();
+            p.culled = false;
+        }
+        std::vector<int> unused;
+        for (int i = 0; i < (int)resources.size(); i++) {
+            resources[i].refCount = (int)resources[i].readers.size() + (resources[i].output ? 1 : 0);
+            if (resources[i].refCount == 0)
+                unused.push_back(i);
+        }
+        while (!unused.empty()) {
+            int res = unused.back();
+            unused.pop_back();
+            for (int writer : resources[res].writers) {
+                Pass& p = passes[writer];
+                if (p.culled || --p.refCount > 0)
+                    continue;
+                p.culled = true;
+                for (int read : p.reads) {
+                    if (--resources[read].refCount == 0)
+                        unused.push_back(read);
+                }
+            }
+        }
+    }
+
+    // Kahn's algorithm, earliest added pass first among the ready ones
+    void sort() {
+        size_t count = passes.size();
+        std::vector<std::vector<int>> edges(count);
+        std::vector<int> incoming(count, 0);
+        auto edge = [&](int from, int to) {
+            if (from == to || passes[from].culled || passes[to].culled)
+                return;
+            edges[from].push_back(to);
+            incoming[to]++;
+        };
+        for (const auto& r : resources) {
+            for (size_t w = 1; w < r.writers.size(); w++)
+                edge(r.writers[w - 1], r.writers[w]);
+            for (int writer : r.writers) {
+                for (int reader : r.readers)
+                    edge(writer, reader);
+            }
+        }
+
+        order.clear();
+        std::vector<bool> done(count, false);
+        size_t alive = 0;
+        for (const auto& p : passes)
+            alive += p.culled ? 0 : 1;
+        while (order.size() < alive) {
+            int next = -1;
+            for (int i = 0; i < (int)count; i++) {
+                if (!done[i] && !passes[i].culled && incoming[i] == 0) {
+                    next = i;
+                    break;
+                }
+            }
+            if (next < 0) {
+                if (!cycleReported)
+                    std::cout << "frame graph has a cycle, running passes in the order they were added" << std::endl;
+                cycleReported = true;
+                order.clear();
+                for (int i = 0; i < (int)count; i++) {
+                    if (!passes[i].culled)
+                        order.push_back(i);
+                }
+                return;
+            }
+            done[next] = true;
+            order.push_back(next);
+            for (int to : edges[next])
+                incoming[to]--;
+        }
+    }
+};
+
+#endif
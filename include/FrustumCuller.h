@@ -0,0 +1,172 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2 1
+#endif
+
+// Six planes (left, right, bottom, top and the two depth planes) pulled out of projection * view.
+// Normals point inwards and are normalized so plane distances are in world units.
+// depthZeroToOne: clip z runs 0..w (glClipControl) instead of GL's default -w..w.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    void extract(const glm::mat4& m, bool depthZeroToOne = false) {
+        // rows of the (column-major) matrix
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[0] = row3 + row0;
+        planes[1] = row3 - row0;
+        planes[2] = row3 + row1;
+        planes[3] = row3 - row1;
+        planes[4] = depthZeroToOne ? row2 : row3 + row2;
+        planes[5] = row3 - row2;
+
+        for (auto& p : planes) {
+            float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            if (length > 0.0f)
+                p /= length;
+        }
+    }
+
+    bool containsSphere(const glm::vec3& center, float radius) const {
+        for (const auto& p : planes) {
+            if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+                return false;
+        }
+        return true;
+    }
+};
+
+// Screen rectangle (pixels, origin bottom left) covering a sphere, from the eight corners of its
+// bounding box. Returns false when the box reaches behind the camera, where projecting it
+// means nothing; callers then have to assume the whole screen.
+inline bool sphereScreenRect(const glm::mat4& viewProjection, const glm::vec3& center, float radius,
+                             int width, int height, glm::ivec4& rect) {
+    glm::vec2 lo(1.0f), hi(-1.0f);
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner = center + radius * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        if (clip.w <= 1e-4f)
+            return false;
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        lo = glm::min(lo, ndc);
+        hi = glm::max(hi, ndc);
+    }
+    lo = glm::clamp(lo, -1.0f, 1.0f);
+    hi = glm::clamp(hi, -1.0f, 1.0f);
+    int x0 = (int)std::floor((lo.x * 0.5f + 0.5f) * width);
+    int y0 = (int)std::floor((lo.y * 0.5f + 0.5f) * height);
+    int x1 = (int)std::ceil((hi.x * 0.5f + 0.5f) * width);
+    int y1 = (int)std::ceil((hi.y * 0.5f + 0.5f) * height);
+    rect = glm::ivec4(x0, y0, x1 - x0 > 0 ? x1 - x0 : 0, y1 - y0 > 0 ? y1 - y0 : 0);
+    return true;
+}
+
+// Bounding spheres stored as structure of arrays so the test runs 4 spheres per step.
+// Fill with add(), call cull(), then walk getVisible() - indices are in insertion order.
+class SphereCullList {
+public:
+    void clear() {
+        centerX.clear();
+        centerY.clear();
+        centerZ.clear();
+        radii.clear();
+        visible.clear();
+    }
+
+    void reserve(size_t count) {
+        centerX.reserve(count);
+        centerY.reserve(count);
+        centerZ.reserve(count);
+        radii.reserve(count);
+        visible.reserve(count);
+    }
+
+    // returns the index used in getVisible()
+    uint32_t add(const glm::vec3& center, float radius) {
+        centerX.push_back(center.x);
+        centerY.push_back(center.y);
+        centerZ.push_back(center.z);
+        radii.push_back(radius);
+        return (uint32_t)(radii.size() - 1);
+    }
+
+    void cull(const Frustum& frustum) {
+        visible.clear();
+        size_t count = radii.size();
+        size_t i = 0;
+
+#ifdef FRUSTUM_CULLER_SSE2
+        __m128 px[6], py[6], pz[6], pw[6];
+        for (int p = 0; p < 6; p++) {
+            px[p] = _mm_set1_ps(frustum.planes[p].x);
+            py[p] = _mm_set1_ps(frustum.planes[p].y);
+            pz[p] = _mm_set1_ps(frustum.planes[p].z);
+            pw[p] = _mm_set1_ps(frustum.planes[p].w);
+        }
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(&centerX[i]);
+            __m128 y = _mm_loadu_ps(&centerY[i]);
+            __m128 z = _mm_loadu_ps(&centerZ[i]);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radii[i]));
+
+            // a lane survives while its distance to every plane is >= -radius
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, px[p]), _mm_mul_ps(y, py[p])),
+                                      _mm_add_ps(_mm_mul_ps(z, pz[p]), pw[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            while (mask) {
+                int lane = ctz(mask);
+                visible.push_back((uint32_t)(i + lane));
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            if (frustum.containsSphere(glm::vec3(centerX[i], centerY[i], centerZ[i]), radii[i]))
+                visible.push_back((uint32_t)i);
+        }
+    }
+
+    // culling disabled - everything is visible
+    void acceptAll() {
+        visible.resize(radii.size());
+        for (size_t i = 0; i < visible.size(); i++)
+            visible[i] = (uint32_t)i;
+    }
+
+    const std::vector<uint32_t>& getVisible() const { return visible; }
+    size_t getCount() const { return radii.size(); }
+    size_t getCulledCount() const { return radii.size() - visible.size(); }
+
+private:
+    std::vector<float> centerX, centerY, centerZ, radii;
+    std::vector<uint32_t> visible;
+
+    static int ctz(int mask) {
+        int lane = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            lane++;
+        }
+        return lane;
+    }
+};
+
+#endif
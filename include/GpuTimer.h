@@ -0,0 +1,69 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+
+// GPU time of a span of commands, from a pair of GL_TIMESTAMP queries per frame.
+// Results are read FRAMES frames later, when the GPU has long finished them, so timing never
+// stalls the pipeline; a result that still isn't available is skipped rather than waited for.
+// Timestamps (unlike GL_TIME_ELAPSED) can nest and overlap, so any number of timers can run.
+class GpuTimer {
+public:
+    static const int FRAMES = 3;
+
+    GpuTimer() : current(0), milliseconds(0.0), initialized(false) {
+        for (int i = 0; i < FRAMES; i++)
+            issued[i] = false;
+    }
+
+    void init() {
+        glGenQueries(FRAMES * 2, &queries[0][0]);
+        initialized = true;
+    }
+
+    void destroy() {
+        if (initialized)
+            glDeleteQueries(FRAMES * 2, &queries[0][0]);
+        initialized = false;
+    }
+
+    void begin() {
+        collect();
+        glQueryCounter(queries[current][0], GL_TIMESTAMP);
+    }
+
+    void end() {
+        glQueryCounter(queries[current][1], GL_TIMESTAMP);
+        issued[current] = true;
+        current = (current + 1) % FRAMES;
+    }
+
+    // smoothed over roughly the last ten results
+    double getMilliseconds() const { return milliseconds; }
+
+private:
+    GLuint queries[FRAMES][2];
+    bool issued[FRAMES];
+    int current;
+    double milliseconds;
+    bool initialized;
+
+    // reads the pair about to be reused
+    void collect() {
+        if (!issued[current])
+            return;
+        issued[current] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(queries[current][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        GLuint64 start = 0, stop = 0;
+        glGetQueryObjectui64v(queries[current][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[current][1], GL_QUERY_RESULT, &stop);
+        double sample = (stop - start) / 1.0e6;
+        milliseconds = milliseconds > 0.0 ? milliseconds * 0.9 + sample * 0.1 : sample;
+    }
+};
+
+#endif
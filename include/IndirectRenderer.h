@@ -0,0 +1,185 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "BodyInstances.h"
+#include "PackedVertex.h"
+
+// GL 4.3+ path: every mesh lives in one vertex/index buffer, draws are written as
+// DrawElementsIndirectCommands and a whole batch goes out in one glMultiDrawElementsIndirect.
+// Per-draw data (model, color, flags) uses the BodyInstance layout on attributes 3-8 and is
+// selected by each command's baseInstance, so it works without gl_DrawID.
+class IndirectRenderer {
+public:
+    struct Mesh {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLint baseVertex;
+    };
+
+    // a contiguous run of commands drawn with one call
+    struct Batch {
+        GLenum mode;
+        unsigned int firstCommand;
+        unsigned int commandCount;
+    };
+
+    IndirectRenderer() : VAO(0), VBO(0), EBO(0), drawDataVBO(0), commandBuffer(0),
+                         drawDataCapacity(0), commandCapacity(0) {}
+
+    // indices are mesh-local (baseVertex does the rest)
+    Mesh addMesh(const std::vector<PackedVertex>& vertices, const std::vector<uint16_t>& indices) {
+        Mesh mesh;
+        mesh.firstIndex = (GLuint)meshIndices.size();
+        mesh.indexCount = (GLuint)indices.size();
+        mesh.baseVertex = (GLint)meshVertices.size();
+        meshVertices.insert(meshVertices.end(), vertices.begin(), vertices.end());
+        meshIndices.insert(meshIndices.end(), indices.begin(), indices.end());
+        return mesh;
+    }
+
+    // uploads the meshes added so far, call once after the last addMesh
+    void init() {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &drawDataVBO);
+        glGenBuffers(1, &commandBuffer);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(PackedVertex), meshVertices.data(), GL_STATIC_DRAW);
+        setupPackedVertexAttributes();
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshIndices.size() * sizeof(uint16_t), meshIndices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, drawDataVBO);
+        for (int i = 0; i < 6; i++) {
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)(i * 4 * sizeof(float)));
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        glBindVertexArray(0);
+
+        meshVertices.clear();
+        meshVertices.shrink_to_fit();
+        meshIndices.clear();
+        meshIndices.shrink_to_fit();
+    }
+
+    void destroy() {
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+            glDeleteBuffers(1, &drawDataVBO);
+            glDeleteBuffers(1, &commandBuffer);
+            VAO = 0;
+        }
+    }
+
+    void begin() {
+        commands.clear();
+        drawData.clear();
+        batchEnds.clear();
+    }
+
+    // one command drawing the mesh once per instance
+    void addInstanced(const Mesh& mesh, const std::vector<BodyInstance>& instances) {
+        if (instances.empty())
+            return;
+        pushCommand(mesh, (GLuint)instances.size());
+        drawData.insert(drawData.end(), instances.begin(), instances.end());
+    }
+
+    // one command drawing the mesh once with this transform
+    void add(const Mesh& mesh, const glm::mat4& model, const glm::vec3& color = glm::vec3(1.0f)) {
+        pushCommand(mesh, 1);
+        BodyInstance instance;
+        instance.model = model;
+        instance.color = glm::vec4(color, -1.0f);
+        instance.flags = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+        drawData.push_back(instance);
+    }
+
+    // groups the commands added since the last batch (or begin) under one primitive mode
+    Batch endBatch(GLenum mode) {
+        Batch batch;
+        batch.mode = mode;
+        batch.firstCommand = batchStart();
+        batch.commandCount = (unsigned int)commands.size() - batch.firstCommand;
+        batchEnds.push_back((unsigned int)commands.size());
+        return batch;
+    }
+
+    // commands and per-draw data for the whole frame in two uploads
+    void upload() {
+        if (commands.empty())
+            return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, drawDataVBO);
+        if (drawData.size() > drawDataCapacity) {
+            drawDataCapacity = (unsigned int)drawData.size() * 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, drawDataCapacity * sizeof(BodyInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, drawData.size() * sizeof(BodyInstance), drawData.data());
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        if (commands.size() > commandCapacity) {
+            commandCapacity = (unsigned int)commands.size() * 2;
+        }
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commandCapacity * sizeof(Command), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(Command), commands.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    void draw(const Batch& batch) {
+        if (batch.commandCount == 0)
+            return;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(batch.mode, GL_UNSIGNED_SHORT,
+                                    (void*)(batch.firstCommand * sizeof(Command)),
+                                    (GLsizei)batch.commandCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    unsigned int getCommandCount() const { return (unsigned int)commands.size(); }
+
+private:
+    // layout fixed by the GL spec
+    struct Command {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    GLuint VAO, VBO, EBO, drawDataVBO, commandBuffer;
+    unsigned int drawDataCapacity, commandCapacity;
+    std::vector<PackedVertex> meshVertices;
+    std::vector<uint16_t> meshIndices;
+    std::vector<Command> commands;
+    std::vector<BodyInstance> drawData;
+    std::vector<unsigned int> batchEnds;
+
+    unsigned int batchStart() const { return batchEnds.empty() ? 0 : batchEnds.back(); }
+
+    void pushCommand(const Mesh& mesh, GLuint instanceCount) {
+        Command command;
+        command.count = mesh.indexCount;
+        command.instanceCount = instanceCount;
+        command.firstIndex = mesh.firstIndex;
+        command.baseVertex = mesh.baseVertex;
+        command.baseInstance = (GLuint)drawData.size();
+        commands.push_back(command);
+    }
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cassert>
+#include <iostream>
+
+// Turns a generator's scanline triangle list into an exactly-sized 16-bit index buffer,
+// reordered with Tipsify (Sander, Nehab, Barczak 2007) so neighbouring triangles reuse
+// vertices still sitting in the GPU's post-transform cache.
+// Meshes must have at most MAX_VERTICES vertices, which callers assert; the LOD spheres draw
+// with a baseVertex, so that limit applies per level, not to the whole buffer.
+class MeshOptimizer {
+public:
+    static const int CACHE_SIZE = 16;   // conservative FIFO size, real hardware is similar or larger
+    static const size_t MAX_VERTICES = 65536;   // what 16-bit indices can address
+
+    // average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is no reuse)
+    template <typename Index>
+    static float acmr(const std::vector<Index>& indices, int cacheSize = CACHE_SIZE) {
+        if (indices.size() < 3)
+            return 0.0f;
+        std::deque<uint32_t> cache;
+        size_t misses = 0;
+        for (Index index : indices) {
+            bool hit = false;
+            for (uint32_t cached : cache) {
+                if (cached == (uint32_t)index) {
+                    hit = true;
+                    break;
+                }
+            }
+            if (hit)
+                continue;
+            misses++;
+            cache.push_back((uint32_t)index);
+            if ((int)cache.size() > cacheSize)
+                cache.pop_front();
+        }
+        return (float)misses / (indices.size() / 3);
+    }
+
+    static std::vector<uint16_t> optimize(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                          int cacheSize = CACHE_SIZE) {
+        assert(vertexCount <= MAX_VERTICES && "mesh too large for 16-bit indices");
+        std::vector<uint16_t> out;
+
+        size_t triangleCount = indices.size() / 3;
+        out.reserve(triangleCount * 3);
+
+        // triangles around each vertex, flattened
+        std::vector<int> live(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            live[indices[i]]++;
+        std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyStart[v + 1] = adjacencyStart[v] + live[v];
+        std::vector<uint32_t> adjacency(adjacencyStart[vertexCount]);
+        std::vector<size_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int c = 0; c < 3; c++)
+                adjacency[fill[indices[t * 3 + c]]++] = (uint32_t)t;
+        }
+
+        std::vector<int> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        int timestamp = cacheSize + 1;
+        size_t cursor = 0;
+        long fanning = triangleCount > 0 ? (long)indices[0] : -1;
+
+        while (fanning >= 0) {
+            // emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (size_t a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++) {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                for (int c = 0; c < 3; c++) {
+                    uint32_t v = indices[t * 3 + c];
+                    out.push_back((uint16_t)v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (timestamp - cacheTime[v] > cacheSize)
+                        cacheTime[v] = timestamp++;
+                }
+                emitted[t] = true;
+            }
+
+            // next fan: the candidate still in cache that stays there longest
+            fanning = -1;
+            int best = -1;
+            for (uint32_t v : candidates) {
+                if (live[v] <= 0)
+                    continue;
+                int priority = 0;
+                if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize)
+                    priority = timestamp - cacheTime[v];
+                if (priority > best) {
+                    best = priority;
+                    fanning = v;
+                }
+            }
+            if (fanning < 0)
+                fanning = skipDeadEnd(live, deadEnd, cursor);
+        }
+        return out;
+    }
+
+    static void report(const char* name, float before, float after) {
+        std::cout << "Mesh optimized: " << name << " (ACMR " << before << " -> " << after << ")" << std::endl;
+    }
+
+private:
+    // recently emitted vertices first, then a linear scan for anything left
+    static long skipDeadEnd(const std::vector<int>& live, std::vector<uint32_t>& deadEnd, size_t& cursor) {
+        while (!deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                return v;
+        }
+        while (cursor < live.size()) {
+            if (live[cursor] > 0)
+                return (long)cursor++;
+            cursor++;
+        }
+        return -1;
+    }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+#include <GL/glew.h>
+#include <vector>
+#include "UniformBuffers.h"
+
+// GL_ANY_SAMPLES_PASSED queries on a box around each body, run after the scene's opaque
+// draws with color and depth writes off. Results are picked up a frame later when the GPU
+// has them (never waited for), so a body coming out from behind the sun shows up one frame
+// late. isVisible() drives the CPU side (instanced draws can't be made conditional per body);
+// draws that belong to a single body go through beginConditional() instead, which lets the
+// GPU drop them on the previous frame's query. Every body alternates between two query
+// objects so this frame's test doesn't overwrite the one the conditional draws still use.
+// A body that wasn't tested (off screen, camera inside its box, queries off) counts as visible.
+class OcclusionQueries {
+public:
+    // keep conditioning on a query for this many frames while its result is late
+    static const int MAX_AGE = 3;
+
+    OcclusionQueries() : VAO(0), VBO(0), EBO(0), frame(0), inConditional(false) {}
+
+    void init(size_t count) {
+        bodies.resize(count);
+        for (auto& b : bodies)
+            glGenQueries(2, b.queries);
+
+        // unit box, positions only; the proxies never reach the color buffer
+        const float corners[] = {
+            -1, -1, -1,   1, -1, -1,   1, 1, -1,   -1, 1, -1,
+            -1, -1,  1,   1, -1,  1,   1, 1,  1,   -1, 1,  1,
+        };
+        const GLubyte indices[] = {
+            0, 1, 2, 2, 3, 0,   4, 6, 5, 6, 4, 7,   0, 4, 5, 5, 1, 0,
+            3, 2, 6, 6, 7, 3,   0, 3, 7, 7, 4, 0,   1, 5, 6, 6, 2, 1,
+        };
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    void destroy() {
+        for (auto& b : bodies)
+            glDeleteQueries(2, b.queries);
+        bodies.clear();
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+    // picks up whatever results have arrived since last frame
+    void beginFrame() {
+        frame++;
+        for (auto& b : bodies) {
+            for (int i = 0; i < 2; i++) {
+                if (!b.pending[i])
+                    continue;
+                GLint available = 0;
+                glGetQueryObjectiv(b.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+                GLuint samples = 0;
+                glGetQueryObjectuiv(b.queries[i], GL_QUERY_RESULT, &samples);
+                b.pending[i] = false;
+                if (b.issuedFrame[i] > b.resultFrame) {
+                    b.visible = samples != 0;
+                    b.resultFrame = b.issuedFrame[i];
+                }
+            }
+        }
+    }
+
+    bool isVisible(size_t index) const { return bodies[index].visible; }
+
+    // the body's real draws are skipped on the GPU if its box had no samples in an earlier
+    // frame; false (and nothing to end) when there is no recent query to go by
+    bool beginConditional(size_t index) {
+        const Body& b = bodies[index];
+        int last = -1;
+        for (int i = 0; i < 2; i++) {
+            if (b.issuedFrame[i] >= 0 && b.issuedFrame[i] < frame && (last < 0 || b.issuedFrame[i] > b.issuedFrame[last]))
+                last = i;
+        }
+        if (last < 0 || frame - b.issuedFrame[last] > MAX_AGE)
+            return false;
+        glBeginConditionalRender(b.queries[last], GL_QUERY_NO_WAIT);
+        inConditional = true;
+        return true;
+    }
+
+    void endConditional() {
+        if (inConditional)
+            glEndConditionalRender();
+        inConditional = false;
+    }
+
+    // after the opaque draws, with a program that reads ObjectData bound
+    void beginTests() {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(VAO);
+    }
+
+    // slot holds the box's model matrix; a query still in flight is left to finish
+    void test(size_t index, int slot, const ObjectUniformBuffer& objects) {
+        Body& b = bodies[index];
+        int i = b.issuedFrame[0] <= b.issuedFrame[1] ? 0 : 1;   // the older one
+        if (b.pending[i])
+            return;
+        objects.bind(slot);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, b.queries[i]);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        b.pending[i] = true;
+        b.issuedFrame[i] = frame;
+    }
+
+    // not tested this frame: draw it normally and forget what the old queries said
+    void skip(size_t index) {
+        Body& b = bodies[index];
+        b.visible = true;
+        for (int i = 0; i < 2; i++) {
+            b.pending[i] = false;
+            b.issuedFrame[i] = -1;
+        }
+        b.resultFrame = -1;
+    }
+
+    void endTests() {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+    }
+
+    int getHiddenCount() const {
+        int hidden = 0;
+        for (const auto& b : bodies)
+            hidden += b.visible ? 0 : 1;
+        return hidden;
+    }
+
+private:
+    struct Body {
+        GLuint queries[2] = {0, 0};
+        bool pending[2] = {false, false};   // issued, result not read back yet
+        int issuedFrame[2] = {-1, -1};
+        bool visible = true;                // newest result that arrived
+        int resultFrame = -1;               // frame that result was issued in
+    };
+
+    std::vector<Body> bodies;
+    GLuint VAO, VBO, EBO;
+    int frame;
+    bool inConditional;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PACKED_VERTEX_H
+#define PACKED_VERTEX_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+// 12-byte vertex for the sphere, ring and indirect orbit meshes (the generators' 8 floats are 32).
+// Positions are snorm16, so meshes are built at unit scale and sized by their model matrix.
+// There is no normal: spheres use their position, the flat ring's normal is always up.
+struct PackedVertex {
+    int16_t position[4];    // xyz in [-1, 1], w padding keeps the uv 4-byte aligned
+    uint16_t texCoord[2];   // unorm16
+};
+
+// from the generators' position, normal, uv layout
+inline std::vector<PackedVertex> packVertices(const std::vector<float>& vertices) {
+    auto snorm = [](float x) {
+        x = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+        return (int16_t)std::lround(x * 32767.0f);
+    };
+    auto unorm = [](float x) {
+        x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+        return (uint16_t)std::lround(x * 65535.0f);
+    };
+
+    std::vector<PackedVertex> packed(vertices.size() / 8);
+    for (size_t i = 0; i < packed.size(); i++) {
+        const float* v = &vertices[i * 8];
+        packed[i].position[0] = snorm(v[0]);
+        packed[i].position[1] = snorm(v[1]);
+        packed[i].position[2] = snorm(v[2]);
+        packed[i].position[3] = 32767;
+        packed[i].texCoord[0] = unorm(v[6]);
+        packed[i].texCoord[1] = unorm(v[7]);
+    }
+    return packed;
+}
+
+// attributes 0 (position) and 2 (uv) from the bound GL_ARRAY_BUFFER, decoded to floats by GL
+inline void setupPackedVertexAttributes() {
+    glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(4 * sizeof(int16_t)));
+    glEnableVertexAttribArray(2);
+}
+
+#endif
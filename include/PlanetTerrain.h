@@ -0,0 +1,711 @@
+#ifndef PLANET_TERRAIN_H
+#define PLANET_TERRAIN_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include "stb_image.h"
+#include "BodyInstances.h"
+#include "FrustumCuller.h"
+#include "MeshOptimizer.h"
+
+// Close-up surface for one planet at a time: a cube projected onto the sphere, each face a
+// quadtree of GRID x GRID chunks. A chunk splits when its grid spacing covers more than
+// pixelError pixels. Chunk vertices are built on worker threads, then uploaded by the main
+// thread into a fixed pool of SLOT_COUNT chunk-sized slots (least recently drawn slots are
+// reused), so memory stays bounded however low the camera goes. Heights come from an
+// equirectangular grayscale elevation map if one exists, otherwise the surface is the plain sphere;
+// the map is decoded on a worker the first time a body is approached and kept (or remembered as
+// missing) from then on. Chunks share one index buffer; skirts hang off every edge to hide cracks
+// between levels.
+class PlanetTerrain {
+public:
+    static const int GRID = 33;                                 // vertices along a chunk edge
+    static const int CHUNK_VERTICES = GRID * GRID + 4 * GRID;   // grid plus skirts
+    static const int SLOT_COUNT = 384;                          // resident chunks (~15 MB of vertices)
+    static const int MAX_LEVEL = 10;
+    static const int MAX_PENDING = 48;                          // chunk jobs queued or being built
+    static const int UPLOADS_PER_FRAME = 16;
+    static_assert(CHUNK_VERTICES <= MeshOptimizer::MAX_VERTICES, "chunk vertices must fit 16-bit indices");
+
+    float pixelError;     // split when a grid cell would be wider than this on screen
+    float heightScale;    // elevation 1.0 in body radii
+
+    PlanetTerrain() : pixelError(8.0f), heightScale(0.02f), VAO(0), VBO(0), EBO(0), instanceVBO(0),
+                      indexCount(0), bodyIndex(-1), frame(0), poolFullFrame(-1000), nextTicket(1),
+                      pendingJobs(0), stopping(false) {}
+
+    // elevationPaths has one image path per body, same indexing as setBody()
+    void init(int workerCount, const std::vector<std::string>& elevationPaths) {
+        buildIndices();
+        elevations.assign(elevationPaths.size(), Elevation());
+        for (size_t i = 0; i < elevationPaths.size(); i++)
+            elevations[i].path = elevationPaths[i];
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &instanceVBO);
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)SLOT_COUNT * CHUNK_VERTICES * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+        // the planet's transform and material, read as instance 0 by every chunk draw
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(BodyInstance), NULL, GL_DYNAMIC_DRAW);
+        for (int i = 0; i < 6; i++) {
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)(i * 4 * sizeof(float)));
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        glBindVertexArray(0);
+
+        for (int i = SLOT_COUNT - 1; i >= 0; i--)
+            freeSlots.push_back(i);
+
+        if (workerCount < 1)
+            workerCount = 1;
+        for (int i = 0; i < workerCount; i++)
+            workers.emplace_back(&PlanetTerrain::workerLoop, this);
+    }
+
+    void destroy() {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+        workers.clear();
+
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+            glDeleteBuffers(1, &instanceVBO);
+            VAO = 0;
+        }
+    }
+
+    // switches to another body (-1 = none), dropping every chunk of the previous one
+    void setBody(int index) {
+        if (index == bodyIndex)
+            return;
+        bodyIndex = index;
+
+        // heightmap loads stay queued, their result is kept for whenever that body comes back
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            auto chunkJobs = std::remove_if(jobs.begin(), jobs.end(), [](const Job& job) { return job.elevationBody < 0; });
+            pendingJobs -= (int)(jobs.end() - chunkJobs);
+            jobs.erase(chunkJobs, jobs.end());
+        }
+        ready.clear();
+        for (const auto& node : nodes) {
+            if (node.slot >= 0)
+                freeSlots.push_back(node.slot);
+        }
+        nodes.clear();
+        freeBlocks.clear();
+        drawList.clear();
+        if (index < 0)
+            return;
+
+        Elevation& elevation = elevations[index];
+        if (elevation.state == ELEVATION_UNKNOWN) {
+            elevation.state = ELEVATION_LOADING;
+            Job job = {};
+            job.node = -1;
+            job.elevationBody = index;
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                jobs.push_front(job);
+            }
+            jobReady.notify_one();
+        }
+        heightmap = elevation.map;
+        for (int face = 0; face < 6; face++)
+            nodes.push_back(makeNode(face, 0, 0, 0));
+    }
+
+    int getBody() const { return bodyIndex; }
+
+    // picks the chunks to draw this frame; model is the body's translate * rotate * scale(radius)
+    void update(const glm::mat4& model, const glm::vec3& cameraPos, const Frustum& frustum, float pixelsPerUnit) {
+        if (bodyIndex < 0)
+            return;
+        frame++;
+        this->model = model;
+        this->frustum = &frustum;
+        this->pixelsPerUnit = pixelsPerUnit;
+        cameraLocal = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+        float cameraDistance = glm::length(cameraLocal);
+        cameraDir = cameraDistance > 0.0f ? cameraLocal / cameraDistance : glm::vec3(0.0f, 1.0f, 0.0f);
+        // angle from the camera direction to the horizon, widened for mountains poking over it
+        horizonAngle = cameraDistance > 1.0f ? acosf(1.0f / cameraDistance) + acosf(1.0f / (1.0f + heightScale)) : 3.2f;
+
+        collectHeightmaps();
+        uploadResults();
+
+        drawList.clear();
+        for (int root = 0; root < 6; root++)
+            visit(root);
+    }
+
+    // the body's instance data (model, color, layers, flags) for the chunk draws
+    void setInstance(const BodyInstance& instance) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(BodyInstance), &instance);
+    }
+
+    // every selected chunk in one glMultiDrawElementsBaseVertex
+    void draw() {
+        if (drawList.empty())
+            return;
+        counts.assign(drawList.size(), (GLsizei)indexCount);
+        offsets.assign(drawList.size(), (void*)0);
+        baseVertices.resize(drawList.size());
+        for (size_t i = 0; i < drawList.size(); i++)
+            baseVertices[i] = drawList[i] * CHUNK_VERTICES;
+
+        glBindVertexArray(VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(),
+                                      (GLsizei)drawList.size(), baseVertices.data());
+        glBindVertexArray(0);
+    }
+
+    size_t getDrawnChunks() const { return drawList.size(); }
+    size_t getTriangleCount() const { return drawList.size() * (indexCount / 3); }
+    int getResidentChunks() const { return SLOT_COUNT - (int)freeSlots.size(); }
+    int getPendingChunks() const { return pendingJobs; }
+    bool hasHeightmap() const { return heightmap != nullptr; }
+
+    // the elevation lookup is done and all six root chunks are built: until then the body is
+    // better drawn as the plain sphere
+    bool isReady() const {
+        if (bodyIndex < 0 || elevations[bodyIndex].state == ELEVATION_LOADING)
+            return false;
+        for (int root = 0; root < 6; root++) {
+            if (nodes[root].slot < 0)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    struct Vertex {
+        float position[3];
+        float normal[3];
+        float texCoord[2];
+    };
+
+    struct Node {
+        int face, level, x, y;
+        int firstChild;          // four consecutive nodes, -1 = leaf
+        int slot;                // vertex pool slot, -1 = not resident
+        bool pending;
+        uint32_t ticket;         // matches results to the node that asked for them
+        glm::vec3 boundCenter;   // unit body space
+        float boundRadius;
+        glm::vec3 direction;     // chunk center on the unit sphere
+        float halfAngle;         // angular radius of the chunk
+        int lastUsedFrame, lastSplitFrame;
+    };
+
+    struct Heightmap {
+        int width, height;
+        std::vector<float> values;   // 0..1, row 0 is the south pole like the surface textures
+    };
+
+    enum ElevationState { ELEVATION_UNKNOWN, ELEVATION_LOADING, ELEVATION_LOADED, ELEVATION_MISSING };
+
+    struct Elevation {
+        std::string path;
+        ElevationState state = ELEVATION_UNKNOWN;
+        std::shared_ptr<const Heightmap> map;
+    };
+
+    struct Job {
+        int node;
+        uint32_t ticket;
+        int face, level, x, y;
+        float heightScale;
+        std::shared_ptr<const Heightmap> heightmap;
+        int elevationBody;   // >= 0: load that body's heightmap instead of building a chunk
+    };
+
+    struct LoadedHeightmap {
+        int body;
+        std::shared_ptr<const Heightmap> map;   // null = no usable image
+    };
+
+    struct Result {
+        int node;
+        uint32_t ticket;
+        std::vector<Vertex> vertices;
+    };
+
+    GLuint VAO, VBO, EBO, instanceVBO;
+    std::vector<uint16_t> indices;
+    unsigned int indexCount;
+
+    int bodyIndex;
+    int frame;
+    int poolFullFrame;       // last time a finished chunk found no slot
+    uint32_t nextTicket;
+    std::shared_ptr<const Heightmap> heightmap;   // the current body's
+    std::vector<Elevation> elevations;
+    std::vector<Node> nodes;
+    std::vector<int> freeBlocks;
+    std::vector<int> freeSlots;
+    std::vector<int> drawList;
+    std::vector<GLsizei> counts;
+    std::vector<void*> offsets;
+    std::vector<GLint> baseVertices;
+
+    // per-update state used by visit()
+    glm::mat4 model;
+    const Frustum* frustum;
+    float pixelsPerUnit;
+    glm::vec3 cameraLocal, cameraDir;
+    float horizonAngle;
+
+    // worker side
+    std::vector<std::thread> workers;
+    std::mutex jobMutex, resultMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    std::vector<Result> results;   // finished by workers, guarded by resultMutex
+    std::vector<LoadedHeightmap> loadedHeightmaps;   // same
+    std::vector<Result> ready;     // main thread side, waiting for upload
+    int pendingJobs;
+    bool stopping;
+
+    // cube face normal and the two in-face axes, chosen so cross(u, v) points outwards
+    static void faceAxes(int face, glm::vec3& normal, glm::vec3& u, glm::vec3& v) {
+        static const float axes[6][9] = {
+            {  1, 0, 0,   0, 1, 0,   0, 0, 1 },
+            { -1, 0, 0,   0, 0, 1,   0, 1, 0 },
+            {  0, 1, 0,   0, 0, 1,   1, 0, 0 },
+            {  0,-1, 0,   1, 0, 0,   0, 0, 1 },
+            {  0, 0, 1,   1, 0, 0,   0, 1, 0 },
+            {  0, 0,-1,   0, 1, 0,   1, 0, 0 },
+        };
+        const float* a = axes[face];
+        normal = glm::vec3(a[0], a[1], a[2]);
+        u = glm::vec3(a[3], a[4], a[5]);
+        v = glm::vec3(a[6], a[7], a[8]);
+    }
+
+    // point on the unit sphere for face coordinates in [-1, 1]
+    static glm::vec3 facePoint(int face, float a, float b) {
+        glm::vec3 normal, u, v;
+        faceAxes(face, normal, u, v);
+        return glm::normalize(normal + u * a + v * b);
+    }
+
+    // same parameterization as Sphere.h: u runs against the azimuth, v from south to north pole
+    static glm::vec2 sphereUV(const glm::vec3& dir) {
+        float s = atan2f(dir.z, dir.x) / 6.28318531f;
+        s -= floorf(s);
+        float y = dir.y < -1.0f ? -1.0f : (dir.y > 1.0f ? 1.0f : dir.y);
+        return glm::vec2(1.0f - s, acosf(-y) / 3.14159265f);
+    }
+
+    static float sampleHeight(const Heightmap* map, const glm::vec3& dir) {
+        if (!map)
+            return 0.0f;
+        glm::vec2 uv = sphereUV(dir);
+        float x = uv.x * map->width - 0.5f;
+        float y = uv.y * (map->height - 1);
+        int x0 = (int)floorf(x);
+        int y0 = (int)y;
+        float fx = x - x0;
+        float fy = y - y0;
+        x0 = ((x0 % map->width) + map->width) % map->width;
+        int x1 = (x0 + 1) % map->width;
+        int y1 = y0 + 1 < map->height ? y0 + 1 : y0;
+
+        const float* row0 = &map->values[(size_t)y0 * map->width];
+        const float* row1 = &map->values[(size_t)y1 * map->width];
+        float bottom = row0[x0] + (row0[x1] - row0[x0]) * fx;
+        float top = row1[x0] + (row1[x1] - row1[x0]) * fx;
+        return bottom + (top - bottom) * fy;
+    }
+
+    // runs on a worker
+    static std::shared_ptr<const Heightmap> loadHeightmap(const std::string& path) {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(1);
+        auto map = std::make_shared<Heightmap>();
+        if (stbi_is_16_bit(path.c_str())) {
+            stbi_us* pixels = stbi_load_16(path.c_str(), &width, &height, &channels, 1);
+            if (!pixels) {
+                std::cout << "Elevation failed to load: " << path << std::endl;
+                return nullptr;
+            }
+            map->values.resize((size_t)width * height);
+            for (size_t i = 0; i < map->values.size(); i++)
+                map->values[i] = pixels[i] / 65535.0f;
+            stbi_image_free(pixels);
+        } else {
+            unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 1);
+            if (!pixels) {
+                std::cout << "No elevation map at " << path << ", terrain stays flat" << std::endl;
+                return nullptr;
+            }
+            map->values.resize((size_t)width * height);
+            for (size_t i = 0; i < map->values.size(); i++)
+                map->values[i] = pixels[i] / 255.0f;
+            stbi_image_free(pixels);
+        }
+        map->width = width;
+        map->height = height;
+        std::cout << "Elevation loaded: " << path << " (" << width << "x" << height << ")" << std::endl;
+        return map;
+    }
+
+    Node makeNode(int face, int level, int x, int y) const {
+        Node node;
+        node.face = face;
+        node.level = level;
+        node.x = x;
+        node.y = y;
+        node.firstChild = -1;
+        node.slot = -1;
+        node.pending = false;
+        node.ticket = 0;
+        node.lastUsedFrame = 0;
+        node.lastSplitFrame = 0;
+
+        float size = 2.0f / (1 << level);
+        float a0 = -1.0f + x * size;
+        float b0 = -1.0f + y * size;
+        node.direction = facePoint(face, a0 + size * 0.5f, b0 + size * 0.5f);
+
+        // corners and edge midpoints at the lowest and highest possible surface
+        float top = 1.0f + heightScale;
+        node.boundCenter = node.direction * (1.0f + heightScale * 0.5f);
+        node.boundRadius = 0.0f;
+        node.halfAngle = 0.0f;
+        for (int j = 0; j <= 2; j++) {
+            for (int i = 0; i <= 2; i++) {
+                glm::vec3 p = facePoint(face, a0 + size * 0.5f * i, b0 + size * 0.5f * j);
+                node.boundRadius = fmaxf(node.boundRadius, glm::length(p - node.boundCenter));
+                node.boundRadius = fmaxf(node.boundRadius, glm::length(p * top - node.boundCenter));
+                node.halfAngle = fmaxf(node.halfAngle, acosf(fminf(glm::dot(p, node.direction), 1.0f)));
+            }
+        }
+        return node;
+    }
+
+    void visit(int index) {
+        {
+            const Node& node = nodes[index];
+            float angle = acosf(fmaxf(fminf(glm::dot(node.direction, cameraDir), 1.0f), -1.0f));
+            if (angle - node.halfAngle > horizonAngle)
+                return;
+            glm::vec3 worldCenter = glm::vec3(model * glm::vec4(node.boundCenter, 1.0f));
+            float worldRadius = node.boundRadius * glm::length(glm::vec3(model[0]));
+            if (!frustum->containsSphere(worldCenter, worldRadius))
+                return;
+        }
+
+        // grid spacing against distance, both in body radii
+        Node& node = nodes[index];
+        float spacing = 1.5707963f / (1 << node.level) / (GRID - 1);
+        float distance = fmaxf(glm::length(cameraLocal - node.boundCenter) - node.boundRadius, 1e-4f);
+        bool split = node.level < MAX_LEVEL && spacing * pixelsPerUnit / distance > pixelError;
+        node.lastUsedFrame = frame;
+
+        if (split) {
+            node.lastSplitFrame = frame;
+            if (node.firstChild < 0)
+                addChildren(index);
+
+            int first = nodes[index].firstChild;
+            bool ready = true;
+            for (int c = first; c < first + 4; c++) {
+                nodes[c].lastUsedFrame = frame;   // wanted, so built siblings aren't evicted while the rest load
+                if (nodes[c].slot < 0) {
+                    ready = false;
+                    request(c);
+                }
+            }
+            if (ready) {
+                for (int c = first; c < first + 4; c++)
+                    visit(c);
+                return;
+            }
+        } else if (node.firstChild >= 0 && frame - node.lastSplitFrame > 90) {
+            removeChildren(index);
+        }
+
+        // coarser chunk stands in until its children are built
+        if (nodes[index].slot >= 0)
+            drawList.push_back(nodes[index].slot);
+        else
+            request(index);
+    }
+
+    void addChildren(int index) {
+        Node parent = nodes[index];
+        int first;
+        if (!freeBlocks.empty()) {
+            first = freeBlocks.back();
+            freeBlocks.pop_back();
+        } else {
+            first = (int)nodes.size();
+            nodes.resize(nodes.size() + 4);
+        }
+        for (int c = 0; c < 4; c++)
+            nodes[first + c] = makeNode(parent.face, parent.level + 1, parent.x * 2 + (c & 1), parent.y * 2 + (c >> 1));
+        nodes[index].firstChild = first;
+    }
+
+    void removeChildren(int index) {
+        int first = nodes[index].firstChild;
+        for (int c = first; c < first + 4; c++) {
+            if (nodes[c].firstChild >= 0)
+                removeChildren(c);
+            if (nodes[c].slot >= 0)
+                freeSlots.push_back(nodes[c].slot);
+            nodes[c].slot = -1;
+            nodes[c].ticket = 0;   // drops results still being built
+        }
+        freeBlocks.push_back(first);
+        nodes[index].firstChild = -1;
+    }
+
+    void request(int index) {
+        Node& node = nodes[index];
+        if (node.pending || pendingJobs >= MAX_PENDING)
+            return;
+        // chunks wait for the heightmap rather than being built flat and thrown away
+        if (elevations[bodyIndex].state == ELEVATION_LOADING)
+            return;
+        // every slot is in use: building more chunks would only throw them away
+        if (freeSlots.empty() && frame - poolFullFrame < 30)
+            return;
+        node.pending = true;
+        node.ticket = nextTicket++;
+
+        Job job = { index, node.ticket, node.face, node.level, node.x, node.y, heightScale, heightmap, -1 };
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobs.push_back(job);
+        }
+        pendingJobs++;
+        jobReady.notify_one();
+    }
+
+    // heightmaps the workers finished; the current body's chunks can start building
+    void collectHeightmaps() {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        for (auto& loaded : loadedHeightmaps) {
+            Elevation& elevation = elevations[loaded.body];
+            elevation.map = loaded.map;
+            elevation.state = loaded.map ? ELEVATION_LOADED : ELEVATION_MISSING;
+            if (loaded.body == bodyIndex)
+                heightmap = loaded.map;
+        }
+        loadedHeightmaps.clear();
+    }
+
+    // finished chunks into pool slots, evicting the least recently drawn chunk when full
+    void uploadResults() {
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            pendingJobs -= (int)results.size();
+            for (auto& result : results)
+                ready.push_back(std::move(result));
+            results.clear();
+        }
+
+        // the rest waits for the next frame so uploads don't spike
+        size_t used = 0;
+        int uploads = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (; used < ready.size() && uploads < UPLOADS_PER_FRAME; used++) {
+            Result& result = ready[used];
+            if (result.node >= (int)nodes.size() || nodes[result.node].ticket != result.ticket)
+                continue;
+            Node& node = nodes[result.node];
+            node.pending = false;
+
+            int slot = acquireSlot();
+            if (slot < 0) {
+                poolFullFrame = frame;
+                continue;   // everything resident is in use, asked for again later
+            }
+            node.slot = slot;
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)slot * CHUNK_VERTICES * sizeof(Vertex),
+                            result.vertices.size() * sizeof(Vertex), result.vertices.data());
+            uploads++;
+        }
+        ready.erase(ready.begin(), ready.begin() + used);
+    }
+
+    int acquireSlot() {
+        if (!freeSlots.empty()) {
+            int slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        // roots stay resident so there is always something to draw
+        int victim = -1;
+        for (int i = 6; i < (int)nodes.size(); i++) {
+            if (nodes[i].slot >= 0 && nodes[i].lastUsedFrame < frame - 1 &&
+                (victim < 0 || nodes[i].lastUsedFrame < nodes[victim].lastUsedFrame))
+                victim = i;
+        }
+        if (victim < 0)
+            return -1;
+        int slot = nodes[victim].slot;
+        nodes[victim].slot = -1;
+        return slot;
+    }
+
+    void workerLoop() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            if (job.elevationBody >= 0) {
+                LoadedHeightmap loaded = { job.elevationBody, loadHeightmap(elevations[job.elevationBody].path) };
+                std::lock_guard<std::mutex> lock(resultMutex);
+                loadedHeightmaps.push_back(std::move(loaded));
+                continue;
+            }
+
+            Result result;
+            result.node = job.node;
+            result.ticket = job.ticket;
+            buildChunk(job, result.vertices);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            results.push_back(std::move(result));
+        }
+    }
+
+    // runs on a worker: displaced grid, normals from neighbouring samples, then the skirts
+    static void buildChunk(const Job& job, std::vector<Vertex>& out) {
+        const Heightmap* map = job.heightmap.get();
+        float size = 2.0f / (1 << job.level);
+        float step = size / (GRID - 1);
+        float a0 = -1.0f + job.x * size;
+        float b0 = -1.0f + job.y * size;
+
+        // one sample of border all around so edge normals match the neighbouring chunk
+        const int SAMPLES = GRID + 2;
+        std::vector<glm::vec3> positions(SAMPLES * SAMPLES);
+        float minHeight = 1.0f, maxHeight = 0.0f;
+        for (int j = 0; j < SAMPLES; j++) {
+            for (int i = 0; i < SAMPLES; i++) {
+                glm::vec3 dir = facePoint(job.face, a0 + (i - 1) * step, b0 + (j - 1) * step);
+                float h = sampleHeight(map, dir);
+                positions[j * SAMPLES + i] = dir * (1.0f + job.heightScale * h);
+                minHeight = fminf(minHeight, h);
+                maxHeight = fmaxf(maxHeight, h);
+            }
+        }
+
+        out.resize(CHUNK_VERTICES);
+        float minU = 1.0f, maxU = 0.0f;
+        for (int j = 0; j < GRID; j++) {
+            for (int i = 0; i < GRID; i++) {
+                const glm::vec3& p = positions[(j + 1) * SAMPLES + (i + 1)];
+                glm::vec3 du = positions[(j + 1) * SAMPLES + (i + 2)] - positions[(j + 1) * SAMPLES + i];
+                glm::vec3 dv = positions[(j + 2) * SAMPLES + (i + 1)] - positions[j * SAMPLES + (i + 1)];
+                glm::vec3 n = glm::normalize(glm::cross(du, dv));
+                glm::vec2 uv = sphereUV(glm::normalize(p));
+
+                Vertex& v = out[j * GRID + i];
+                v.position[0] = p.x; v.position[1] = p.y; v.position[2] = p.z;
+                v.normal[0] = n.x; v.normal[1] = n.y; v.normal[2] = n.z;
+                v.texCoord[0] = uv.x; v.texCoord[1] = uv.y;
+                minU = fminf(minU, uv.x);
+                maxU = fmaxf(maxU, uv.x);
+            }
+        }
+
+        // chunks across the u seam would interpolate through the whole map, the array repeats in u
+        if (maxU - minU > 0.5f) {
+            for (int i = 0; i < GRID * GRID; i++) {
+                if (out[i].texCoord[0] < 0.5f)
+                    out[i].texCoord[0] += 1.0f;
+            }
+        }
+
+        // skirts: edge vertices pulled down by the largest gap a coarser neighbour's edge can
+        // leave, which is the relief inside this chunk plus the sag of a cell twice as wide
+        // (1 - cos(step) ~ step^2 / 2), with some margin
+        float depth = 1.5f * (job.heightScale * fmaxf(maxHeight - minHeight, 0.0f) + 0.5f * step * step) + 1e-5f;
+        for (int k = 0; k < GRID; k++) {
+            int edges[4] = { k, (GRID - 1) * GRID + k, k * GRID, k * GRID + GRID - 1 };
+            for (int e = 0; e < 4; e++) {
+                Vertex v = out[edges[e]];
+                glm::vec3 p(v.position[0], v.position[1], v.position[2]);
+                p -= glm::normalize(p) * depth;
+                v.position[0] = p.x; v.position[1] = p.y; v.position[2] = p.z;
+                out[GRID * GRID + e * GRID + k] = v;
+            }
+        }
+    }
+
+    void buildIndices() {
+        std::vector<unsigned int> scanline;
+        for (int j = 0; j < GRID - 1; j++) {
+            for (int i = 0; i < GRID - 1; i++) {
+                unsigned int a = j * GRID + i;
+                scanline.insert(scanline.end(), { a, a + 1, a + GRID + 1, a, a + GRID + 1, a + GRID });
+            }
+        }
+        // bottom, top, left and right edges against their skirt vertices
+        for (int e = 0; e < 4; e++) {
+            for (int k = 0; k < GRID - 1; k++) {
+                unsigned int edge0, edge1;
+                if (e == 0)      { edge0 = k;                    edge1 = k + 1; }
+                else if (e == 1) { edge0 = (GRID - 1) * GRID + k; edge1 = edge0 + 1; }
+                else if (e == 2) { edge0 = k * GRID;             edge1 = edge0 + GRID; }
+                else             { edge0 = k * GRID + GRID - 1;  edge1 = edge0 + GRID; }
+                unsigned int skirt0 = GRID * GRID + e * GRID + k;
+                scanline.insert(scanline.end(), { edge0, edge1, skirt0 + 1, edge0, skirt0 + 1, skirt0 });
+            }
+        }
+
+        indices = MeshOptimizer::optimize(scanline, CHUNK_VERTICES);
+        indexCount = (unsigned int)indices.size();
+        MeshOptimizer::report("terrain chunk", MeshOptimizer::acmr(scanline), MeshOptimizer::acmr(indices));
+    }
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Linked programs saved with glGetProgramBinary and handed back to glProgramBinary on the
+// next launch, so the driver's compile and link only run when something changed. One file
+// per program (named after its shader paths and defines, so an edited shader overwrites its
+// old entry), holding a hash of the full sources and of the vendor/renderer/version strings.
+// A different hash, a binary the driver refuses or no binary formats at all (pre-4.1 without
+// ARB_get_program_binary) all mean compiling from source as before.
+class ProgramCache {
+public:
+    static const uint32_t FILE_VERSION = 1;
+
+    ProgramCache() : enabled(false), driverHash(0), hits(0), misses(0), loadMs(0.0), compileMs(0.0), savedMs(0.0) {}
+
+    // after glewInit; directory is created if missing
+    void init(const std::string& cacheDirectory) {
+        directory = cacheDirectory;
+        GLint formats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats == 0) {
+            std::cout << "Program cache off: driver has no program binary formats" << std::endl;
+            return;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cout << "Program cache off: cannot create " << directory << std::endl;
+            return;
+        }
+
+        std::string driver;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            const GLubyte* text = glGetString(name);
+            driver += text ? (const char*)text : "";
+            driver += '\n';
+        }
+        driverHash = hash(driver);
+        enabled = true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    // FNV-1a, 64 bit
+    static uint64_t hash(const std::string& text) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // linked program from the cache, or 0 when it has to be built from source
+    GLuint load(const std::string& name, uint64_t sourceHash) {
+        if (!enabled)
+            return 0;
+        auto start = Clock::now();
+        std::string path = pathFor(name);
+        std::ifstream file(path, std::ios::binary);
+        Header header;
+        if (!file || !file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, "SPRG", 4) != 0 ||
+            header.version != FILE_VERSION || header.sourceHash != sourceHash || header.driverHash != driverHash)
+            return 0;
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), binary.size()))
+            return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            // driver update it didn't announce in the version string: rebuild and overwrite
+            while (glGetError() != GL_NO_ERROR) {}
+            glDeleteProgram(program);
+            std::cout << "Program cache entry rejected by the driver: " << name << std::endl;
+            return 0;
+        }
+
+        double ms = elapsedMs(start);
+        hits++;
+        loadMs += ms;
+        savedMs += header.compileMs - ms;
+        return program;
+    }
+
+    // before glLinkProgram, so the driver keeps the binary around
+    void prepare(GLuint program) const {
+        if (enabled)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // after a successful link from source; compileMs is what the next launch saves
+    void store(const std::string& name, uint64_t sourceHash, GLuint program, double programCompileMs) {
+        misses++;
+        compileMs += programCompileMs;
+        if (!enabled)
+            return;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        Header header;
+        std::memcpy(header.magic, "SPRG", 4);
+        header.version = FILE_VERSION;
+        header.sourceHash = sourceHash;
+        header.driverHash = driverHash;
+        header.compileMs = (float)programCompileMs;
+        glGetProgramBinary(program, length, NULL, &header.format, binary.data());
+        header.length = (uint32_t)length;
+
+        std::string path = pathFor(name);
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            file.write(binary.data(), binary.size());
+            if (!file) {
+                std::cout << "Program cache entry could not be written: " << path << std::endl;
+                return;
+            }
+        }
+        std::remove(path.c_str());
+        std::rename(temp.c_str(), path.c_str());
+    }
+
+    // one startup line: how many programs came from the cache and what that saved
+    void report() const {
+        char line[256];
+        snprintf(line, sizeof(line), "shader programs: %d from cache in %.1f ms, %d compiled in %.1f ms, %.1f ms of compiling saved",
+                 hits, loadMs, misses, compileMs, savedMs);
+        std::cout << line << (enabled ? "" : " (cache off)") << std::endl;
+    }
+
+    int getHits() const { return hits; }
+    int getMisses() const { return misses; }
+    double getSavedMs() const { return savedMs; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t driverHash;
+        GLenum format;
+        uint32_t length;
+        float compileMs;
+        uint32_t padding = 0;
+    };
+
+    bool enabled;
+    std::string directory;
+    uint64_t driverHash;
+    int hits, misses;
+    double loadMs, compileMs, savedMs;
+
+    std::string pathFor(const std::string& name) const {
+        char file[32];
+        snprintf(file, sizeof(file), "%016llx.bin", (unsigned long long)hash(name));
+        return (std::filesystem::path(directory) / file).string();
+    }
+
+    static double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+};
+
+#endif
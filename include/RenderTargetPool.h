@@ -0,0 +1,141 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <GL/glew.h>
+#include <vector>
+
+// Render target textures shared by every pass, keyed by (format, width, height).
+// A pass acquires what it needs and releases it as soon as its contents are no longer read,
+// so a later pass asking for the same kind of target gets the same texture back instead of
+// new memory. Sizes follow the framebuffer: targets of an old size simply stop being asked
+// for and trim() deletes them once they have been idle long enough.
+class RenderTargetPool {
+public:
+    struct Target {
+        GLuint texture;
+        GLenum format;
+        int width, height;
+        unsigned int acquisitions;   // bumped on every acquire; unchanged since a pass last held it = contents intact
+    };
+
+    RenderTargetPool() : frame(0), frameAcquires(0), frameReuses(0), allocations(0) {}
+
+    void beginFrame() {
+        frame++;
+        frameAcquires = 0;
+        frameReuses = 0;
+    }
+
+    // a free target of this kind, allocated if there is none; valid until release()
+    Target acquire(GLenum format, int width, int height) {
+        frameAcquires++;
+        int found = -1;
+        for (int i = 0; i < (int)entries.size(); i++) {
+            const Entry& e = entries[i];
+            if (!e.inUse && e.target.format == format && e.target.width == width && e.target.height == height) {
+                found = i;
+                break;
+            }
+        }
+        if (found < 0) {
+            found = (int)entries.size();
+            entries.push_back(allocate(format, width, height));
+            allocations++;
+        } else if (entries[found].lastReleasedFrame == frame) {
+            frameReuses++;   // another pass already finished with it this frame
+        }
+
+        Entry& e = entries[found];
+        e.inUse = true;
+        e.target.acquisitions++;
+        return e.target;
+    }
+
+    void release(GLuint texture) {
+        for (auto& e : entries) {
+            if (e.target.texture == texture && e.inUse) {
+                e.inUse = false;
+                e.lastReleasedFrame = frame;
+                return;
+            }
+        }
+    }
+
+    // deletes free targets nobody asked for in the last maxIdleFrames frames
+    void trim(int maxIdleFrames) {
+        for (size_t i = 0; i < entries.size();) {
+            if (!entries[i].inUse && frame - entries[i].lastReleasedFrame >= maxIdleFrames) {
+                glDeleteTextures(1, &entries[i].target.texture);
+                entries[i] = entries.back();
+                entries.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    void destroy() {
+        for (auto& e : entries)
+            glDeleteTextures(1, &e.target.texture);
+        entries.clear();
+    }
+
+    size_t getBytes() const {
+        size_t bytes = 0;
+        for (const auto& e : entries)
+            bytes += (size_t)e.target.width * e.target.height * bytesPerPixel(e.target.format);
+        return bytes;
+    }
+    int getCount() const { return (int)entries.size(); }
+    int getFrameAcquires() const { return frameAcquires; }
+    int getFrameReuses() const { return frameReuses; }
+    // textures ever created; a change means a deleted name may have come back for a new texture
+    unsigned int getAllocations() const { return allocations; }
+
+    static size_t bytesPerPixel(GLenum format) {
+        switch (format) {
+            case GL_RGBA16F: return 8;
+            case GL_RGBA8: return 4;
+            case GL_R11F_G11F_B10F: return 4;
+            case GL_DEPTH_COMPONENT24: return 4;   // padded to 32 bits in practice
+            case GL_DEPTH_COMPONENT32F: return 4;
+            default: return 4;
+        }
+    }
+
+private:
+    struct Entry {
+        Target target;
+        bool inUse;
+        int lastReleasedFrame;
+    };
+
+    std::vector<Entry> entries;
+    int frame;
+    int frameAcquires, frameReuses;
+    unsigned int allocations;
+
+    Entry allocate(GLenum format, int width, int height) {
+        bool depth = format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F;
+        GLenum type = format == GL_DEPTH_COMPONENT24 ? GL_UNSIGNED_INT : (format == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT);
+
+        Entry e;
+        e.target.format = format;
+        e.target.width = width;
+        e.target.height = height;
+        e.target.acquisitions = 0;
+        e.inUse = false;
+        e.lastReleasedFrame = frame;
+
+        glGenTextures(1, &e.target.texture);
+        glBindTexture(GL_TEXTURE_2D, e.target.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, depth ? GL_DEPTH_COMPONENT : GL_RGBA, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return e;
+    }
+};
+
+#endif
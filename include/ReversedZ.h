@@ -0,0 +1,54 @@
+#ifndef REVERSED_Z_H
+#define REVERSED_Z_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cmath>
+
+// Depth runs from 1 at the near plane to 0 at the far plane and is stored as 32-bit float.
+// Floats are densest around 0, which reversed-Z puts at the far end where perspective spreads
+// depth thinnest, so the error stays about even over the whole range and near can shrink to
+// a few meters while far reaches past neptune.
+// With glClipControl (4.5 or ARB_clip_control) clip z maps straight to [0,1]. Without it the
+// matrix targets [-1,1] and GL's 0.5z + 0.5 window transform loses some of that precision
+// far away, but the depth test, clears and everything else stay the same.
+class ReversedZ {
+public:
+    static constexpr float MIN_NEAR = 1e-5f;
+
+    ReversedZ() : zeroToOne(false) {}
+
+    // depth state for the whole program, once after the context is up
+    void init() {
+        zeroToOne = GLEW_VERSION_4_5 || GLEW_ARB_clip_control;
+        if (zeroToOne)
+            glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+        glDepthFunc(GL_GREATER);
+        glClearDepth(0.0);
+    }
+
+    // like glm::perspective, depth 1 at near and 0 at far
+    glm::mat4 perspective(float fovy, float aspect, float near, float far) const {
+        float f = 1.0f / tanf(fovy * 0.5f);
+        glm::mat4 m(0.0f);
+        m[0][0] = f / aspect;
+        m[1][1] = f;
+        m[2][3] = -1.0f;
+        if (zeroToOne) {
+            m[2][2] = near / (far - near);
+            m[3][2] = far * near / (far - near);
+        } else {
+            m[2][2] = (far + near) / (far - near);
+            m[3][2] = 2.0f * far * near / (far - near);
+        }
+        return m;
+    }
+
+    // clip z goes 0..w rather than -w..w, see Frustum::extract
+    bool isZeroToOne() const { return zeroToOne; }
+
+private:
+    bool zeroToOne;
+};
+
+#endif
@@ -3,13 +3,17 @@
 
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cassert>
+#include "MeshOptimizer.h"
 
 const float PI_RING = 3.14159265359f;
 
 class Ring {
 public:
     std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<uint16_t> indices;    // cache-optimized, see MeshOptimizer
+    float acmrBefore, acmrAfter;
 
     Ring(float innerRadius, float outerRadius, unsigned int segments) {
         // Create a flat ring in XZ plane
@@ -45,8 +49,8 @@ public:
         }
 
         // Create indices for triangle strip
-        indices.resize(segments * 6);
-        std::vector<unsigned int>::iterator idx = indices.begin();
+        std::vector<unsigned int> scanline(segments * 6);
+        std::vector<unsigned int>::iterator idx = scanline.begin();
 
         for (unsigned int i = 0; i < segments; ++i) {
             unsigned int innerCurrent = i * 2;
@@ -64,6 +68,11 @@ public:
             *idx++ = outerCurrent;
             *idx++ = outerNext;
         }
+
+        assert((segments + 1) * 2 <= MeshOptimizer::MAX_VERTICES && "ring needs 32-bit indices");
+        indices = MeshOptimizer::optimize(scanline, (segments + 1) * 2);
+        acmrBefore = MeshOptimizer::acmr(scanline);
+        acmrAfter = MeshOptimizer::acmr(indices);
     }
 };
 
@@ -0,0 +1,349 @@
+#ifndef RING_PARTICLES_H
+#define RING_PARTICLES_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include "stb_image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RING_PARTICLES_SSE2 1
+#endif
+
+const float TWO_PI_RING_PARTICLES = 6.28318530718f;
+
+// Particle mode for planetary rings, used for close flybys.
+// Everything lives in the ring's local frame (same units as the Ring mesh, i.e. planet radii).
+// The ring is split into radial bands and angular sectors; sectors near the camera are
+// filled lazily from a fixed pool of slots, and every particle carries its own Keplerian
+// angular velocity so inner particles overtake outer ones (shear).
+class RingParticleSystem {
+public:
+    float innerRadius;
+    float outerRadius;
+    unsigned int bands;              // radial subdivisions
+    unsigned int sectorsPerBand;     // angular subdivisions
+    unsigned int particlesPerSector; // multiple of 4 for the simd kernel
+    unsigned int maxActiveSectors;   // pool size in sectors
+    unsigned int maxSectorsPerFrame; // generation budget per update
+
+    float innerAngularSpeed;         // rad/s at the inner edge, falls off as r^-1.5
+    float activationRadius;          // sectors closer than this to the camera get particles
+    float particleSize;              // particle diameter in local units
+    float thickness;                 // vertical spread in local units
+
+    RingParticleSystem(float innerRadius, float outerRadius,
+                       unsigned int bands = 16, unsigned int sectorsPerBand = 128,
+                       unsigned int particlesPerSector = 2048, unsigned int maxActiveSectors = 512)
+        : innerRadius(innerRadius), outerRadius(outerRadius),
+          bands(bands), sectorsPerBand(sectorsPerBand),
+          particlesPerSector((particlesPerSector + 3) & ~3u), maxActiveSectors(maxActiveSectors),
+          maxSectorsPerFrame(16), innerAngularSpeed(0.25f), activationRadius(2.0f),
+          particleSize(0.004f), thickness(0.01f),
+          VAO(0), staticVBO(0), angleVBO(0), initialized(false)
+    {
+        unsigned int sectorCount = bands * sectorsPerBand;
+        sectorSlot.assign(sectorCount, -1);
+        slotSector.assign(maxActiveSectors, -1);
+        for (int i = (int)maxActiveSectors - 1; i >= 0; i--) {
+            freeSlots.push_back(i);
+        }
+
+        size_t capacity = (size_t)maxActiveSectors * this->particlesPerSector;
+        angles.assign(capacity, 0.0f);
+        omegas.assign(capacity, 0.0f);
+
+        bandPhase.assign(bands, 0.0f);
+        bandOmega.resize(bands);
+        for (unsigned int b = 0; b < bands; b++) {
+            bandOmega[b] = angularSpeedAt(bandMidRadius(b));
+        }
+
+        // uniform density until a profile is loaded
+        densityProfile.assign(1, 1.0f);
+    }
+
+    // call while the gl context is still alive
+    void destroy() {
+        if (initialized) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &staticVBO);
+            glDeleteBuffers(1, &angleVBO);
+            initialized = false;
+        }
+    }
+
+    // build radial density from the ring texture alpha (u = inner -> outer edge)
+    bool loadDensityProfile(const char* path) {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 4);
+        if (!data) {
+            std::cout << "ring density profile failed to load: " << path << std::endl;
+            return false;
+        }
+
+        densityProfile.assign(width, 0.0f);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                densityProfile[x] += data[(y * width + x) * 4 + 3] / 255.0f;
+            }
+        }
+        for (int x = 0; x < width; x++) {
+            densityProfile[x] /= (float)height;
+        }
+        stbi_image_free(data);
+        return true;
+    }
+
+    void init() {
+        size_t capacity = angles.size();
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &staticVBO);
+        glGenBuffers(1, &angleVBO);
+
+        glBindVertexArray(VAO);
+
+        // static attributes: radius, height, size, brightness
+        glBindBuffer(GL_ARRAY_BUFFER, staticVBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // current orbital angle, streamed every frame
+        glBindBuffer(GL_ARRAY_BUFFER, angleVBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(float), NULL, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+        initialized = true;
+    }
+
+    // cameraLocal is the camera position in the ring's local frame
+    void update(float deltaTime, const glm::vec3& cameraLocal) {
+        for (unsigned int b = 0; b < bands; b++) {
+            bandPhase[b] = wrapAngle(bandPhase[b] + bandOmega[b] * deltaTime);
+        }
+
+        // rank every sector by distance to the camera
+        candidates.clear();
+        unsigned int sectorCount = bands * sectorsPerBand;
+        for (unsigned int sector = 0; sector < sectorCount; sector++) {
+            float dist = glm::length(sectorCenter(sector) - cameraLocal);
+            bool active = sectorSlot[sector] >= 0;
+            // a little hysteresis so sectors on the boundary don't thrash
+            float limit = active ? activationRadius * 1.1f : activationRadius;
+            if (dist < limit) {
+                candidates.push_back(std::make_pair(dist, sector));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        if (candidates.size() > maxActiveSectors) {
+            candidates.resize(maxActiveSectors);
+        }
+
+        // release sectors that fell out of range
+        wanted.assign(sectorCount, 0);
+        for (const auto& c : candidates) {
+            wanted[c.second] = 1;
+        }
+        for (unsigned int slot = 0; slot < maxActiveSectors; slot++) {
+            int sector = slotSector[slot];
+            if (sector >= 0 && !wanted[sector]) {
+                sectorSlot[sector] = -1;
+                slotSector[slot] = -1;
+                freeSlots.push_back(slot);
+            }
+        }
+
+        // fill the nearest missing sectors, limited per frame
+        unsigned int generated = 0;
+        for (const auto& c : candidates) {
+            if (generated >= maxSectorsPerFrame || freeSlots.empty())
+                break;
+            if (sectorSlot[c.second] >= 0)
+                continue;
+            int slot = freeSlots.back();
+            freeSlots.pop_back();
+            generateSector(c.second, slot);
+            generated++;
+        }
+
+        // advance every active particle
+        activeParticles = 0;
+        for (unsigned int slot = 0; slot < maxActiveSectors; slot++) {
+            if (slotSector[slot] < 0)
+                continue;
+            size_t first = (size_t)slot * particlesPerSector;
+            advanceAngles(&angles[first], &omegas[first], particlesPerSector, deltaTime);
+            activeParticles += particlesPerSector;
+        }
+    }
+
+    // upload the streamed angles and draw all active sectors as points
+    void draw() {
+        if (!initialized || activeParticles == 0)
+            return;
+
+        drawFirsts.clear();
+        drawCounts.clear();
+        int lowSlot = -1, highSlot = -1;
+        for (unsigned int slot = 0; slot < maxActiveSectors; slot++) {
+            if (slotSector[slot] < 0)
+                continue;
+            if (lowSlot < 0)
+                lowSlot = slot;
+            highSlot = slot;
+            drawFirsts.push_back((GLint)(slot * particlesPerSector));
+            drawCounts.push_back((GLsizei)particlesPerSector);
+        }
+
+        // one upload covering the span of active slots
+        size_t first = (size_t)lowSlot * particlesPerSector;
+        size_t count = (size_t)(highSlot - lowSlot + 1) * particlesPerSector;
+        glBindBuffer(GL_ARRAY_BUFFER, angleVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(float), count * sizeof(float), &angles[first]);
+
+        glBindVertexArray(VAO);
+        glMultiDrawArrays(GL_POINTS, drawFirsts.data(), drawCounts.data(), (GLsizei)drawFirsts.size());
+        glBindVertexArray(0);
+    }
+
+    unsigned int getActiveParticles() const { return activeParticles; }
+    unsigned int getCapacity() const { return (unsigned int)angles.size(); }
+
+    float angularSpeedAt(float radius) const {
+        return innerAngularSpeed * std::pow(radius / innerRadius, -1.5f);
+    }
+
+private:
+    GLuint VAO, staticVBO, angleVBO;
+    bool initialized;
+    unsigned int activeParticles = 0;
+
+    std::vector<float> angles;        // per particle, dynamic
+    std::vector<float> omegas;        // per particle, keplerian angular velocity
+    std::vector<float> bandPhase;     // rotation of each band's sector grid
+    std::vector<float> bandOmega;
+    std::vector<float> densityProfile;
+
+    std::vector<int> sectorSlot;      // sector -> slot, -1 if inactive
+    std::vector<int> slotSector;      // slot -> sector, -1 if free
+    std::vector<int> freeSlots;
+
+    std::vector<std::pair<float, unsigned int>> candidates;
+    std::vector<unsigned char> wanted;
+    std::vector<GLint> drawFirsts;
+    std::vector<GLsizei> drawCounts;
+    std::vector<float> staticScratch;
+
+    float bandMidRadius(unsigned int band) const {
+        float width = (outerRadius - innerRadius) / bands;
+        return innerRadius + width * (band + 0.5f);
+    }
+
+    glm::vec3 sectorCenter(unsigned int sector) const {
+        unsigned int band = sector / sectorsPerBand;
+        unsigned int s = sector % sectorsPerBand;
+        float angle = bandPhase[band] + TWO_PI_RING_PARTICLES * (s + 0.5f) / sectorsPerBand;
+        float r = bandMidRadius(band);
+        return glm::vec3(r * cos(angle), 0.0f, r * sin(angle));
+    }
+
+    static float wrapAngle(float angle) {
+        angle = fmod(angle, TWO_PI_RING_PARTICLES);
+        return angle < 0.0f ? angle + TWO_PI_RING_PARTICLES : angle;
+    }
+
+    float densityAt(float radius) const {
+        float u = (radius - innerRadius) / (outerRadius - innerRadius);
+        int x = (int)(u * (densityProfile.size() - 1) + 0.5f);
+        x = std::max(0, std::min((int)densityProfile.size() - 1, x));
+        return densityProfile[x];
+    }
+
+    // fills one slot with a deterministic particle set for the given sector
+    void generateSector(unsigned int sector, int slot) {
+        unsigned int band = sector / sectorsPerBand;
+        unsigned int s = sector % sectorsPerBand;
+        float bandWidth = (outerRadius - innerRadius) / bands;
+        float r0 = innerRadius + bandWidth * band;
+        float sectorWidth = TWO_PI_RING_PARTICLES / sectorsPerBand;
+        float a0 = bandPhase[band] + sectorWidth * s;
+
+        // same sector always produces the same particles
+        uint32_t state = sector * 2654435761u + 1u;
+        auto random = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state & 0xFFFFFF) / 16777216.0f;
+        };
+
+        size_t first = (size_t)slot * particlesPerSector;
+        staticScratch.resize(particlesPerSector * 4);
+
+        for (unsigned int i = 0; i < particlesPerSector; i++) {
+            // rejection sample the radius against the texture density (gaps stay empty)
+            float radius = r0 + random() * bandWidth;
+            for (int attempt = 0; attempt < 8 && random() > densityAt(radius); attempt++) {
+                radius = r0 + random() * bandWidth;
+            }
+            float density = densityAt(radius);
+
+            float height = (random() + random() + random() - 1.5f) * thickness;
+            float size = particleSize * (0.5f + random());
+            // empty regions keep a few faint particles instead of dropping slots
+            float brightness = (0.6f + 0.4f * random()) * std::max(density, 0.05f);
+
+            angles[first + i] = wrapAngle(a0 + random() * sectorWidth);
+            omegas[first + i] = angularSpeedAt(radius);
+
+            staticScratch[i * 4 + 0] = radius;
+            staticScratch[i * 4 + 1] = height;
+            staticScratch[i * 4 + 2] = size;
+            staticScratch[i * 4 + 3] = brightness;
+        }
+
+        if (initialized) {
+            glBindBuffer(GL_ARRAY_BUFFER, staticVBO);
+            glBufferSubData(GL_ARRAY_BUFFER, first * 4 * sizeof(float),
+                            particlesPerSector * 4 * sizeof(float), staticScratch.data());
+        }
+
+        sectorSlot[sector] = slot;
+        slotSector[slot] = (int)sector;
+    }
+
+    // angle += omega * dt, wrapped to [0, 2pi); count is a multiple of 4
+    static void advanceAngles(float* angle, const float* omega, unsigned int count, float deltaTime) {
+#ifdef RING_PARTICLES_SSE2
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        const __m128 twoPi = _mm_set1_ps(TWO_PI_RING_PARTICLES);
+        const __m128 invTwoPi = _mm_set1_ps(1.0f / TWO_PI_RING_PARTICLES);
+        for (unsigned int i = 0; i < count; i += 4) {
+            __m128 a = _mm_loadu_ps(angle + i);
+            __m128 w = _mm_loadu_ps(omega + i);
+            a = _mm_add_ps(a, _mm_mul_ps(w, dt));
+            // angles stay positive, so truncation is floor
+            __m128 turns = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(a, invTwoPi)));
+            a = _mm_sub_ps(a, _mm_mul_ps(turns, twoPi));
+            _mm_storeu_ps(angle + i, a);
+        }
+#else
+        for (unsigned int i = 0; i < count; i++) {
+            float a = angle[i] + omega[i] * deltaTime;
+            a -= (float)(int)(a * (1.0f / TWO_PI_RING_PARTICLES)) * TWO_PI_RING_PARTICLES;
+            angle[i] = a;
+        }
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include "UniformBuffers.h"
+
+// Per-frame uniform counters for the debug panel.
+struct UniformStats {
+    unsigned int lookupsAvoided = 0;   // sets by handle, each a glGetUniformLocation by name before
+    unsigned int redundantSkipped = 0; // sets skipped because the value didn't change
+    unsigned int uploads = 0;          // glUniform* calls actually issued
+
+    void reset() { lookupsAvoided = redundantSkipped = uploads = 0; }
+};
+
+inline UniformStats uniformStats;
+
+// Linked program plus a table of its active uniforms, built once with glGetActiveUniform.
+// Shared uniform blocks (FrameData, ObjectData) are attached to their binding points here.
+// Per-frame code resolves handles with param() at startup and sets values by handle;
+// the last value of every uniform is kept so unchanged values are not re-sent.
+// Setters assume the program is currently bound; debug builds assert the value matches
+// the uniform's declared type.
+class ShaderProgram {
+public:
+    struct Param {
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint size;
+        float cache[16];
+        bool cached;
+    };
+
+    GLuint id;
+    std::vector<Param> params;
+
+    ShaderProgram() : id(0) {}
+    explicit ShaderProgram(GLuint program) : id(0) { reflect(program); }
+
+    void reflect(GLuint program) {
+        id = program;
+        params.clear();
+        lookup.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> nameBuffer(std::max(maxLength, 1));
+
+        for (GLint i = 0; i < count; i++) {
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, (GLuint)i, (GLsizei)nameBuffer.size(), NULL, &size, &type, nameBuffer.data());
+
+            Param p;
+            p.name = nameBuffer.data();
+            // arrays are reported as "name[0]"
+            size_t bracket = p.name.find('[');
+            if (bracket != std::string::npos)
+                p.name = p.name.substr(0, bracket);
+            p.location = glGetUniformLocation(program, nameBuffer.data());
+            p.type = type;
+            p.size = size;
+            p.cached = false;
+
+            // uniform block members have no location
+            if (p.location < 0)
+                continue;
+
+            lookup[p.name] = (int)params.size();
+            params.push_back(p);
+        }
+
+        GLint blockCount = 0, maxBlockLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockLength);
+        std::vector<char> blockName(std::max(maxBlockLength, 1));
+
+        for (GLint i = 0; i < blockCount; i++) {
+            glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)blockName.size(), NULL, blockName.data());
+            int binding = uniformBlockBinding(blockName.data());
+            if (binding >= 0)
+                glUniformBlockBinding(program, (GLuint)i, (GLuint)binding);
+            else
+                std::cout << "unknown uniform block in program " << program << ": " << blockName.data() << std::endl;
+        }
+    }
+
+    // handle for a uniform, -1 if the program doesn't use it (sets on -1 are ignored)
+    int param(const char* name) const {
+        auto it = lookup.find(name);
+        if (it == lookup.end()) {
+            std::cout << "uniform not active in program " << id << ": " << name << std::endl;
+            return -1;
+        }
+        return it->second;
+    }
+
+    GLenum typeOf(int handle) const { return handle >= 0 ? params[handle].type : 0; }
+
+    void set(int handle, bool value) { set(handle, (int)value); }
+
+    void set(int handle, int value) {
+        float bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        assert((handle < 0 || isIntType(params[handle].type)) && "int set on a non-int uniform");
+        if (changed(handle, &bits, 1))
+            glUniform1i(params[handle].location, value);
+    }
+
+    void set(int handle, float value) {
+        assert((handle < 0 || params[handle].type == GL_FLOAT) && "float set on a non-float uniform");
+        if (changed(handle, &value, 1))
+            glUniform1f(params[handle].location, value);
+    }
+
+    void set(int handle, const glm::vec2& value) {
+        assert((handle < 0 || params[handle].type == GL_FLOAT_VEC2) && "vec2 set on a non-vec2 uniform");
+        if (changed(handle, glm::value_ptr(value), 2))
+            glUniform2fv(params[handle].location, 1, glm::value_ptr(value));
+    }
+
+    void set(int handle, float x, float y, float z) {
+        set(handle, glm::vec3(x, y, z));
+    }
+
+    void set(int handle, const glm::vec3& value) {
+        assert((handle < 0 || params[handle].type == GL_FLOAT_VEC3) && "vec3 set on a non-vec3 uniform");
+        if (changed(handle, glm::value_ptr(value), 3))
+            glUniform3fv(params[handle].location, 1, glm::value_ptr(value));
+    }
+
+    void set(int handle, const glm::mat4& value) {
+        assert((handle < 0 || params[handle].type == GL_FLOAT_MAT4) && "mat4 set on a non-mat4 uniform");
+        if (changed(handle, glm::value_ptr(value), 16))
+            glUniformMatrix4fv(params[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+private:
+    std::unordered_map<std::string, int> lookup;
+
+    // uniforms glUniform1i is valid for: ints, bools and samplers
+    static bool isIntType(GLenum type) {
+        switch (type) {
+        case GL_INT: case GL_BOOL:
+        case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_CUBE_SHADOW: case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool changed(int handle, const float* data, size_t count) {
+        if (handle < 0)
+            return false;
+        uniformStats.lookupsAvoided++;
+
+        Param& p = params[handle];
+        if (p.cached && std::memcmp(p.cache, data, count * sizeof(float)) == 0) {
+            uniformStats.redundantSkipped++;
+            return false;
+        }
+        std::memcpy(p.cache, data, count * sizeof(float));
+        p.cached = true;
+        uniformStats.uploads++;
+        return true;
+    }
+};
+
+#endif
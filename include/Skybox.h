@@ -0,0 +1,371 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "stb_image.h"
+
+// Background sky as a cube map made from an equirectangular image (textures/stars.jpg).
+// The conversion and the whole mip chain run once on a loader thread and are written to a
+// cache file next to the image; later runs just read that file. Levels come out smallest
+// first: the small ones are uploaded as soon as they exist, the large ones a few faces per
+// frame, and GL_TEXTURE_BASE_LEVEL only drops to a level once all six of its faces are in,
+// so the sky starts blurry and sharpens over the first frames instead of holding up startup.
+class Skybox {
+public:
+    static const int MAX_FACE = 2048;                  // 8192 wide equirectangular = 2048 per 90 degrees
+    static const int IMMEDIATE_SIZE = 256;             // levels up to this size skip the upload budget
+    static const size_t UPLOAD_BUDGET = 8u << 20;      // bytes of larger levels per frame (at least one face)
+
+    Skybox() : textureID(0), VAO(0), VBO(0), faceSize(0), baseLevel(-1), stopping(false) {}
+
+    void init(const std::string& imagePath, const std::string& cachePath) {
+        // unit cube, drawn from the inside
+        const float corners[] = {
+            -1,  1, -1,  -1, -1, -1,   1, -1, -1,   1, -1, -1,   1,  1, -1,  -1,  1, -1,
+            -1, -1,  1,  -1, -1, -1,  -1,  1, -1,  -1,  1, -1,  -1,  1,  1,  -1, -1,  1,
+             1, -1, -1,   1, -1,  1,   1,  1,  1,   1,  1,  1,   1,  1, -1,   1, -1, -1,
+            -1, -1,  1,  -1,  1,  1,   1,  1,  1,   1,  1,  1,   1, -1,  1,  -1, -1,  1,
+            -1,  1, -1,   1,  1, -1,   1,  1,  1,   1,  1,  1,  -1,  1,  1,  -1,  1, -1,
+            -1, -1, -1,  -1, -1,  1,   1, -1, -1,   1, -1, -1,  -1, -1,  1,   1, -1,  1,
+        };
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+        loader = std::thread(&Skybox::load, this, imagePath, cachePath);
+    }
+
+    void destroy() {
+        stopping = true;
+        if (loader.joinable())
+            loader.join();
+        if (textureID != 0)
+            glDeleteTextures(1, &textureID);
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+        }
+        textureID = VAO = VBO = 0;
+    }
+
+    // uploads what the loader has finished, once per frame
+    void update() {
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            for (auto& level : results)
+                ready.push_back(std::move(level));
+            results.clear();
+        }
+        if (ready.empty())
+            return;
+
+        if (textureID == 0)
+            allocate(ready.front().size, ready.front().index + 1);
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        size_t uploaded = 0;
+        while (!ready.empty()) {
+            Level& level = ready.front();
+            size_t faceBytes = (size_t)level.size * level.size * 3;
+            if (level.size > IMMEDIATE_SIZE && uploaded > 0 && uploaded + faceBytes > UPLOAD_BUDGET)
+                break;
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + level.facesUploaded, level.index, 0, 0, level.size, level.size,
+                            GL_RGB, GL_UNSIGNED_BYTE, &level.pixels[level.facesUploaded * faceBytes]);
+            if (level.size > IMMEDIATE_SIZE)
+                uploaded += faceBytes;
+            if (++level.facesUploaded < 6)
+                continue;
+
+            // complete, sample from here down
+            baseLevel = level.index;
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, baseLevel);
+            ready.pop_front();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+
+    // nothing to draw until the smallest level is in
+    bool isReady() const { return baseLevel >= 0; }
+
+    // binds the cube map to unit 0; the caller has the skybox program bound and depth off
+    void draw() const {
+        if (!isReady())
+            return;
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    // face size of the sharpest level uploaded so far, 0 before the first
+    int getResidentSize() const { return isReady() ? faceSize >> baseLevel : 0; }
+    int getFaceSize() const { return faceSize; }
+
+private:
+    struct Level {
+        int index;                         // mip level, 0 = faceSize
+        int size;
+        std::vector<unsigned char> pixels; // six RGB faces in GL order (+x, -x, +y, -y, +z, -z)
+        int facesUploaded = 0;
+    };
+
+    // cache file: header, then the levels smallest first, each six faces of RGB
+    struct CacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t faceSize;
+        uint32_t levelCount;
+        // the image it was made from, a changed image rebuilds it
+        uint64_t sourceBytes;
+        int64_t sourceModified;   // last write time, in the filesystem clock's ticks
+        uint64_t sourceHash;      // FNV-1a of the first SOURCE_HASH_BYTES
+    };
+    static const uint32_t CACHE_VERSION = 2;
+    static const size_t SOURCE_HASH_BYTES = 64 * 1024;
+
+    GLuint textureID, VAO, VBO;
+    int faceSize, baseLevel;
+    std::thread loader;
+    std::atomic<bool> stopping;
+    std::mutex resultMutex;
+    std::deque<Level> results;   // loader -> main thread
+    std::deque<Level> ready;     // waiting for upload budget
+
+    // every level allocated up front, filled in as they arrive
+    void allocate(int smallestSize, int levels) {
+        faceSize = smallestSize << (levels - 1);
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+        for (int level = 0; level < levels; level++) {
+            int size = faceSize >> level;
+            for (int face = 0; face < 6; face++)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB8, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    void publish(Level&& level) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        results.push_back(std::move(level));
+    }
+
+    // runs on the loader thread
+    void load(std::string imagePath, std::string cachePath) {
+        CacheHeader key = {};
+        if (!describeSource(imagePath, key)) {
+            std::cout << "Skybox image not found: " << imagePath << std::endl;
+            return;
+        }
+        if (loadCache(cachePath, key))
+            return;
+
+        std::vector<Level> levels;
+        if (!convert(imagePath, levels))
+            return;
+        // cache first so the levels can be handed over without a copy, smallest first as in the cache
+        writeCache(cachePath, key, levels);
+        for (int i = (int)levels.size() - 1; i >= 0 && !stopping; i--)
+            publish(std::move(levels[i]));
+    }
+
+    // size, modification time and a hash of the start of the image, for the cache header
+    static bool describeSource(const std::string& imagePath, CacheHeader& key) {
+        std::ifstream source(imagePath, std::ios::binary | std::ios::ate);
+        if (!source)
+            return false;
+        key.sourceBytes = (uint64_t)source.tellg();
+        std::error_code error;
+        auto modified = std::filesystem::last_write_time(imagePath, error);
+        key.sourceModified = error ? 0 : (int64_t)modified.time_since_epoch().count();
+
+        std::vector<char> head((size_t)std::min<uint64_t>(key.sourceBytes, SOURCE_HASH_BYTES));
+        source.seekg(0);
+        source.read(head.data(), head.size());
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : head) {
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ull;
+        }
+        key.sourceHash = hash;
+        return true;
+    }
+
+    bool loadCache(const std::string& path, const CacheHeader& key) {
+        std::ifstream file(path, std::ios::binary);
+        CacheHeader header;
+        if (!file || !file.read((char*)&header, sizeof(header)))
+            return false;
+        if (std::memcmp(header.magic, "SKYC", 4) != 0 || header.version != CACHE_VERSION ||
+            header.sourceBytes != key.sourceBytes || header.sourceModified != key.sourceModified ||
+            header.sourceHash != key.sourceHash || header.levelCount == 0 || header.faceSize >> (header.levelCount - 1) != 1)
+            return false;
+
+        for (int index = (int)header.levelCount - 1; index >= 0 && !stopping; index--) {
+            Level level;
+            level.index = index;
+            level.size = (int)header.faceSize >> index;
+            level.pixels.resize((size_t)level.size * level.size * 3 * 6);
+            if (!file.read((char*)level.pixels.data(), level.pixels.size())) {
+                // truncated: what was published stays, the rest never arrives
+                std::cout << "Skybox cache truncated: " << path << std::endl;
+                return true;
+            }
+            publish(std::move(level));
+        }
+        std::cout << "Skybox loaded from cache: " << path << " (" << header.faceSize << " per face)" << std::endl;
+        return true;
+    }
+
+    void writeCache(const std::string& path, const CacheHeader& key, const std::vector<Level>& levels) {
+        // written aside and renamed, so an interrupted run never leaves half a cache
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            CacheHeader header = key;
+            std::memcpy(header.magic, "SKYC", 4);
+            header.version = CACHE_VERSION;
+            header.faceSize = (uint32_t)levels[0].size;
+            header.levelCount = (uint32_t)levels.size();
+            file.write((const char*)&header, sizeof(header));
+            for (int i = (int)levels.size() - 1; i >= 0; i--)
+                file.write((const char*)levels[i].pixels.data(), levels[i].pixels.size());
+            if (!file) {
+                std::cout << "Skybox cache could not be written: " << path << std::endl;
+                return;
+            }
+        }
+        std::remove(path.c_str());
+        if (std::rename(temp.c_str(), path.c_str()) == 0)
+            std::cout << "Skybox cache written: " << path << std::endl;
+    }
+
+    // equirectangular image -> level 0 faces, then 2x2 averages down to 1x1
+    bool convert(const std::string& imagePath, std::vector<Level>& levels) {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(0);   // row 0 = north
+        unsigned char* image = stbi_load(imagePath.c_str(), &width, &height, &channels, 3);
+        if (!image) {
+            std::cout << "Skybox image failed to load: " << imagePath << std::endl;
+            return false;
+        }
+
+        int size = 1;
+        while (size * 2 <= width / 4 && size * 2 <= MAX_FACE)
+            size *= 2;
+
+        Level top;
+        top.index = 0;
+        top.size = size;
+        top.pixels.resize((size_t)size * size * 3 * 6);
+        for (int face = 0; face < 6 && !stopping; face++) {
+            for (int y = 0; y < size; y++) {
+                float t = 2.0f * (y + 0.5f) / size - 1.0f;
+                for (int x = 0; x < size; x++) {
+                    float s = 2.0f * (x + 0.5f) / size - 1.0f;
+                    float dir[3];
+                    faceDirection(face, s, t, dir);
+                    sampleEquirect(image, width, height, dir, &top.pixels[(((size_t)face * size + y) * size + x) * 3]);
+                }
+            }
+        }
+        stbi_image_free(image);
+        levels.push_back(std::move(top));
+
+        while (levels.back().size > 1 && !stopping) {
+            const Level& src = levels.back();
+            Level level;
+            level.index = src.index + 1;
+            level.size = src.size / 2;
+            level.pixels.resize((size_t)level.size * level.size * 3 * 6);
+            for (int face = 0; face < 6; face++) {
+                for (int y = 0; y < level.size; y++) {
+                    for (int x = 0; x < level.size; x++) {
+                        for (int c = 0; c < 3; c++) {
+                            int sum = 0;
+                            for (int k = 0; k < 4; k++) {
+                                size_t sx = 2 * x + (k & 1), sy = 2 * y + (k >> 1);
+                                sum += src.pixels[(((size_t)face * src.size + sy) * src.size + sx) * 3 + c];
+                            }
+                            level.pixels[(((size_t)face * level.size + y) * level.size + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+                        }
+                    }
+                }
+            }
+            levels.push_back(std::move(level));
+        }
+        if (stopping)
+            return false;
+        std::cout << "Skybox converted to a cube map: " << imagePath << " (" << size << " per face)" << std::endl;
+        return true;
+    }
+
+    // direction through texel (s, t) in [-1, 1] of a face, GL's cube map face orientation
+    static void faceDirection(int face, float s, float t, float* dir) {
+        switch (face) {
+            case 0: dir[0] = 1.0f; dir[1] = -t;    dir[2] = -s;   break;   // +x
+            case 1: dir[0] = -1.0f; dir[1] = -t;   dir[2] = s;    break;   // -x
+            case 2: dir[0] = s;    dir[1] = 1.0f;  dir[2] = t;    break;   // +y
+            case 3: dir[0] = s;    dir[1] = -1.0f; dir[2] = -t;   break;   // -y
+            case 4: dir[0] = s;    dir[1] = -t;    dir[2] = 1.0f; break;   // +z
+            default: dir[0] = -s;  dir[1] = -t;    dir[2] = -1.0f; break;  // -z
+        }
+    }
+
+    // bilinear, u wraps around, v clamps at the poles; same mapping the old shader used
+    static void sampleEquirect(const unsigned char* image, int width, int height, const float* dir, unsigned char* out) {
+        float length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        float u = std::atan2(dir[2], dir[0]) / 6.28318531f + 0.5f;
+        float v = std::asin(dir[1] / length) / 3.14159265f + 0.5f;
+
+        float sx = u * width - 0.5f;
+        float sy = (1.0f - v) * height - 0.5f;
+        if (sx < 0.0f) sx += width;
+        if (sy < 0.0f) sy = 0.0f;
+        int x0 = (int)sx % width;
+        int x1 = (x0 + 1) % width;
+        int y0 = (int)sy < height ? (int)sy : height - 1;
+        int y1 = y0 + 1 < height ? y0 + 1 : height - 1;
+        float fx = sx - (int)sx;
+        float fy = sy - (int)sy;
+
+        const unsigned char* p00 = &image[((size_t)y0 * width + x0) * 3];
+        const unsigned char* p10 = &image[((size_t)y0 * width + x1) * 3];
+        const unsigned char* p01 = &image[((size_t)y1 * width + x0) * 3];
+        const unsigned char* p11 = &image[((size_t)y1 * width + x1) * 3];
+        for (int c = 0; c < 3; c++) {
+            float top = p00[c] + (p10[c] - p00[c]) * fx;
+            float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+            out[c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+        }
+    }
+};
+
+#endif
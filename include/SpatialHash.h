@@ -0,0 +1,390 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+// Uniform grid hashed by cell coordinate, for "what is near this point" queries.
+// Items are dense ids (0..n-1) with a position and a radius; distances are measured
+// to the item's surface (center distance - radius), so points just use radius 0.
+// update() only touches the grid when an item crosses into another cell.
+class SpatialHash {
+public:
+    struct Result {
+        int id;
+        float distance;   // surface distance, negative when inside
+        bool operator<(const Result& other) const { return distance < other.distance; }
+    };
+
+    SpatialHash(float cellSize = 50.0f) : cellSize(cellSize), invCellSize(1.0f / cellSize), maxRadius(0.0f) {}
+
+    // picks a cell size that puts a couple of items in each cell
+    static float suggestCellSize(float extent, size_t count) {
+        float cells = std::cbrt(std::max((float)count, 1.0f) / 2.0f);
+        return std::max(extent / std::max(cells, 1.0f), 0.001f);
+    }
+
+    void clear() {
+        cells.clear();
+        cellLookup.clear();
+        freeCells.clear();
+        items.clear();
+        maxRadius = 0.0f;
+        hasBounds = false;
+    }
+
+    void reserve(size_t count) {
+        items.reserve(count);
+        cells.reserve(count);
+        cellLookup.reserve(count);
+    }
+
+    size_t size() const { return items.size(); }
+    float getCellSize() const { return cellSize; }
+
+    // (re)places an item; an id that is already in the grid moves to its new cell,
+    // negative ids are ignored
+    void insert(int id, const glm::vec3& position, float radius = 0.0f) {
+        if (id < 0)
+            return;
+        if (id >= (int)items.size())
+            items.resize(id + 1);
+        if (items[id].cell >= 0)
+            removeFromCell(id);
+        Item& item = items[id];
+        item.position = position;
+        item.radius = radius;
+        maxRadius = std::max(maxRadius, radius);
+        addToCell(id, cellKey(cellCoord(position)));
+    }
+
+    // incremental move, cheap when the item stays in its cell; ids not in the grid
+    // (never inserted or removed) are ignored
+    void update(int id, const glm::vec3& position) {
+        if (id < 0 || id >= (int)items.size() || items[id].cell < 0)
+            return;
+        Item& item = items[id];
+        item.position = position;
+        int64_t key = cellKey(cellCoord(position));
+        if (key != cells[item.cell].key) {
+            removeFromCell(id);
+            addToCell(id, key);
+        }
+    }
+
+    void remove(int id) {
+        if (id >= 0 && id < (int)items.size() && items[id].cell >= 0) {
+            removeFromCell(id);
+        }
+    }
+
+    // every item whose surface is within radius of center
+    void queryRadius(const glm::vec3& center, float radius, std::vector<Result>& out) const {
+        out.clear();
+        float reach = radius + maxRadius;
+        glm::ivec3 lo = cellCoord(center - glm::vec3(reach));
+        glm::ivec3 hi = cellCoord(center + glm::vec3(reach));
+        for (int x = lo.x; x <= hi.x; x++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int z = lo.z; z <= hi.z; z++) {
+                    auto it = cellLookup.find(cellKey(glm::ivec3(x, y, z)));
+                    if (it == cellLookup.end())
+                        continue;
+                    for (int id : cells[it->second].ids) {
+                        float d = glm::length(items[id].position - center) - items[id].radius;
+                        if (d <= radius)
+                            out.push_back({id, d});
+                    }
+                }
+            }
+        }
+    }
+
+    // k closest surfaces, sorted by distance; walks outward one shell of cells at a time
+    void queryNearest(const glm::vec3& center, size_t k, std::vector<Result>& out) const {
+        out.clear();
+        if (k == 0 || cellLookup.empty())
+            return;
+
+        glm::ivec3 origin = cellCoord(center);
+        int maxShell = shellLimit(origin);
+
+        for (int shell = 0; shell <= maxShell; shell++) {
+            for (int x = -shell; x <= shell; x++) {
+                for (int y = -shell; y <= shell; y++) {
+                    // only the surface of the shell cube, the inside was visited already
+                    bool onFace = std::abs(x) == shell || std::abs(y) == shell;
+                    int step = onFace ? 1 : 2 * shell;
+                    for (int z = -shell; z <= shell; z += std::max(step, 1)) {
+                        auto it = cellLookup.find(cellKey(glm::ivec3(origin.x + x, origin.y + y, origin.z + z)));
+                        if (it == cellLookup.end())
+                            continue;
+                        for (int id : cells[it->second].ids) {
+                            float d = glm::length(items[id].position - center) - items[id].radius;
+                            if (out.size() < k) {
+                                out.push_back({id, d});
+                                std::push_heap(out.begin(), out.end());
+                            } else if (d < out.front().distance) {
+                                std::pop_heap(out.begin(), out.end());
+                                out.back() = {id, d};
+                                std::push_heap(out.begin(), out.end());
+                            }
+                        }
+                    }
+                }
+            }
+
+            // nothing outside this shell can be closer than shell * cellSize - maxRadius
+            if (out.size() == k && out.front().distance <= shell * cellSize - maxRadius)
+                break;
+        }
+
+        std::sort_heap(out.begin(), out.end());
+    }
+
+    // closest surface to a point, -1 if empty
+    int nearest(const glm::vec3& center, float* distance = nullptr) const {
+        std::vector<Result>& scratch = nearestScratch;
+        queryNearest(center, 1, scratch);
+        if (scratch.empty())
+            return -1;
+        if (distance)
+            *distance = scratch[0].distance;
+        return scratch[0].id;
+    }
+
+private:
+    struct Item {
+        glm::vec3 position;
+        float radius = 0.0f;
+        int cell = -1;        // index into cells
+        int slot = -1;        // index inside the cell's id list
+    };
+
+    struct Cell {
+        int64_t key;
+        glm::ivec3 coord;
+        std::vector<int> ids;
+    };
+
+    float cellSize;
+    float invCellSize;
+    float maxRadius;
+    std::vector<Item> items;
+    std::vector<Cell> cells;
+    std::vector<int> freeCells;
+    std::unordered_map<int64_t, int> cellLookup;
+    glm::ivec3 boundsMin = glm::ivec3(0, 0, 0);
+    glm::ivec3 boundsMax = glm::ivec3(0, 0, 0);
+    bool hasBounds = false;
+    mutable std::vector<Result> nearestScratch;
+
+    glm::ivec3 cellCoord(const glm::vec3& p) const {
+        return glm::ivec3((int)std::floor(p.x * invCellSize),
+                          (int)std::floor(p.y * invCellSize),
+                          (int)std::floor(p.z * invCellSize));
+    }
+
+    // 21 bits per axis
+    static int64_t cellKey(const glm::ivec3& c) {
+        const int64_t mask = (1 << 21) - 1;
+        return ((int64_t)(c.x & mask) << 42) | ((int64_t)(c.y & mask) << 21) | (int64_t)(c.z & mask);
+    }
+
+    // shells beyond the occupied bounds can't contain anything
+    int shellLimit(const glm::ivec3& origin) const {
+        int limit = 0;
+        limit = std::max(limit, std::abs(origin.x - boundsMin.x));
+        limit = std::max(limit, std::abs(origin.x - boundsMax.x));
+        limit = std::max(limit, std::abs(origin.y - boundsMin.y));
+        limit = std::max(limit, std::abs(origin.y - boundsMax.y));
+        limit = std::max(limit, std::abs(origin.z - boundsMin.z));
+        limit = std::max(limit, std::abs(origin.z - boundsMax.z));
+        return limit;
+    }
+
+    void addToCell(int id, int64_t key) {
+        int cellIndex;
+        auto it = cellLookup.find(key);
+        if (it != cellLookup.end()) {
+            cellIndex = it->second;
+        } else {
+            if (!freeCells.empty()) {
+                cellIndex = freeCells.back();
+                freeCells.pop_back();
+            } else {
+                cellIndex = (int)cells.size();
+                cells.push_back(Cell());
+            }
+            Cell& cell = cells[cellIndex];
+            cell.key = key;
+            cell.coord = cellCoord(items[id].position);
+            cell.ids.clear();
+            cellLookup[key] = cellIndex;
+
+            // bounds only grow, which keeps them conservative
+            if (!hasBounds) {
+                boundsMin = boundsMax = cell.coord;
+                hasBounds = true;
+            } else {
+                boundsMin = glm::ivec3(std::min(boundsMin.x, cell.coord.x), std::min(boundsMin.y, cell.coord.y), std::min(boundsMin.z, cell.coord.z));
+                boundsMax = glm::ivec3(std::max(boundsMax.x, cell.coord.x), std::max(boundsMax.y, cell.coord.y), std::max(boundsMax.z, cell.coord.z));
+            }
+        }
+
+        Item& item = items[id];
+        item.cell = cellIndex;
+        item.slot = (int)cells[cellIndex].ids.size();
+        cells[cellIndex].ids.push_back(id);
+    }
+
+    void removeFromCell(int id) {
+        Item& item = items[id];
+        Cell& cell = cells[item.cell];
+
+        // swap-remove and fix the moved item's slot
+        int last = cell.ids.back();
+        cell.ids[item.slot] = last;
+        items[last].slot = item.slot;
+        cell.ids.pop_back();
+
+        if (cell.ids.empty()) {
+            cellLookup.erase(cell.key);
+            freeCells.push_back(item.cell);
+        }
+        item.cell = -1;
+        item.slot = -1;
+    }
+};
+
+// Compares the grid against the brute-force loop for 10^3 - 10^6 random bodies.
+// Run with --benchmark-spatial.
+inline void runSpatialHashBenchmark() {
+    typedef std::chrono::high_resolution_clock Clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    const float extent = 1000.0f;
+    const int queries = 1000;
+    const size_t k = 8;
+
+    std::cout << "spatial hash benchmark (" << queries << " queries, k = " << k << ")" << std::endl;
+    std::cout << std::setw(9) << "bodies" << std::setw(11) << "build ms" << std::setw(12) << "update ms"
+              << std::setw(14) << "knn hash ms" << std::setw(15) << "knn brute ms"
+              << std::setw(17) << "radius hash ms" << std::setw(18) << "radius brute ms" << std::endl;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(-extent * 0.5f, extent * 0.5f);
+    std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+
+    for (size_t count = 1000; count <= 1000000; count *= 10) {
+        std::vector<glm::vec3> positions(count);
+        for (auto& p : positions) {
+            p = glm::vec3(coord(rng), coord(rng), coord(rng));
+        }
+        std::vector<glm::vec3> queryPoints(queries);
+        for (auto& q : queryPoints) {
+            q = glm::vec3(coord(rng), coord(rng), coord(rng));
+        }
+
+        float cellSize = SpatialHash::suggestCellSize(extent, count);
+        // radius that hits ~16 bodies on average
+        float queryRadius = std::cbrt(16.0f * extent * extent * extent / count * 3.0f / (4.0f * 3.14159265f));
+
+        auto t0 = Clock::now();
+        SpatialHash hash(cellSize);
+        hash.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            hash.insert((int)i, positions[i]);
+        }
+        auto t1 = Clock::now();
+
+        // one simulation step worth of small moves
+        float step = cellSize * 0.1f;
+        for (size_t i = 0; i < count; i++) {
+            positions[i] += glm::vec3(jitter(rng), jitter(rng), jitter(rng)) * step;
+            hash.update((int)i, positions[i]);
+        }
+        auto t2 = Clock::now();
+
+        std::vector<SpatialHash::Result> result;
+        size_t checksum = 0;
+        for (const auto& q : queryPoints) {
+            hash.queryNearest(q, k, result);
+            checksum += result.size();
+        }
+        auto t3 = Clock::now();
+
+        std::vector<std::vector<SpatialHash::Result>> bruteNearest(queries);
+        for (int qi = 0; qi < queries; qi++) {
+            const glm::vec3& q = queryPoints[qi];
+            std::vector<SpatialHash::Result>& brute = bruteNearest[qi];
+            brute.reserve(k);
+            for (size_t i = 0; i < count; i++) {
+                float d = glm::length(positions[i] - q);
+                if (brute.size() < k) {
+                    brute.push_back({(int)i, d});
+                    std::push_heap(brute.begin(), brute.end());
+                } else if (d < brute.front().distance) {
+                    std::pop_heap(brute.begin(), brute.end());
+                    brute.back() = {(int)i, d};
+                    std::push_heap(brute.begin(), brute.end());
+                }
+            }
+        }
+        auto t4 = Clock::now();
+
+        std::vector<size_t> radiusHash(queries), radiusBrute(queries);
+        for (int qi = 0; qi < queries; qi++) {
+            hash.queryRadius(queryPoints[qi], queryRadius, result);
+            radiusHash[qi] = result.size();
+        }
+        auto t5 = Clock::now();
+
+        for (int qi = 0; qi < queries; qi++) {
+            size_t found = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (glm::length(positions[i] - queryPoints[qi]) <= queryRadius)
+                    found++;
+            }
+            radiusBrute[qi] = found;
+        }
+        auto t6 = Clock::now();
+
+        // every answer checked against brute force, outside the timings; ties may pick
+        // different ids, so the distances are compared
+        int mismatches = 0;
+        for (int qi = 0; qi < queries; qi++) {
+            std::vector<SpatialHash::Result>& brute = bruteNearest[qi];
+            std::sort_heap(brute.begin(), brute.end());
+            hash.queryNearest(queryPoints[qi], k, result);
+            bool same = result.size() == brute.size();
+            for (size_t i = 0; same && i < result.size(); i++)
+                same = result[i].distance == brute[i].distance;
+            if (!same || radiusHash[qi] != radiusBrute[qi])
+                mismatches++;
+            checksum += radiusHash[qi];
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(9) << count << std::setw(11) << ms(t0, t1) << std::setw(12) << ms(t1, t2)
+                  << std::setw(14) << ms(t2, t3) << std::setw(15) << ms(t3, t4)
+                  << std::setw(17) << ms(t4, t5) << std::setw(18) << ms(t5, t6);
+        if (mismatches > 0)
+            std::cout << "  (" << mismatches << " of " << queries << " queries mismatched!)";
+        std::cout << std::endl;
+        (void)checksum;
+    }
+}
+
+#endif
@@ -3,13 +3,17 @@
 
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cassert>
+#include "MeshOptimizer.h"
 
 const float PI = 3.14159265359f;
 
 class Sphere {
 public:
     std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<uint16_t> indices;    // cache-optimized, see MeshOptimizer
+    float acmrBefore, acmrAfter;
 
     Sphere(float radius, unsigned int rings, unsigned int sectors) {
         float const R = 1.0f / (float)(rings - 1);
@@ -40,8 +44,8 @@ public:
             }
         }
 
-        indices.resize(rings * sectors * 6);
-        std::vector<unsigned int>::iterator i = indices.begin();
+        std::vector<unsigned int> scanline((rings - 1) * (sectors - 1) * 6);
+        std::vector<unsigned int>::iterator i = scanline.begin();
 
         for(unsigned int r = 0; r < rings - 1; ++r) {
             for(unsigned int s = 0; s < sectors - 1; ++s) {
@@ -54,6 +58,11 @@ public:
                 *i++ = (r + 1) * sectors + s;
             }
         }
+
+        assert(rings * sectors <= MeshOptimizer::MAX_VERTICES && "sphere level needs 32-bit indices");
+        indices = MeshOptimizer::optimize(scanline, rings * sectors);
+        acmrBefore = MeshOptimizer::acmr(scanline);
+        acmrAfter = MeshOptimizer::acmr(indices);
     }
 };
 
@@ -0,0 +1,81 @@
+#ifndef SPHERE_LOD_H
+#define SPHERE_LOD_H
+
+#include <vector>
+#include <cstdint>
+#include "Sphere.h"
+#include "PackedVertex.h"
+
+// Unit spheres from 8x16 up to 128x256 (rings x sectors) packed into one vertex/index array
+// of 12-byte PackedVertex.
+// A body's level follows its projected radius in pixels; each level needs the radius to
+// clear its threshold by a margin before switching up, and to drop below it by the same
+// margin before switching down, so bodies near a boundary don't flicker between levels.
+class SphereLOD {
+public:
+    struct Level {
+        unsigned int rings, sectors;
+        float minPixels;           // smallest screen radius that uses this level
+        unsigned int firstIndex;
+        unsigned int indexCount;
+        int baseVertex;
+        float acmrBefore, acmrAfter;
+    };
+
+    std::vector<Level> levels;
+    std::vector<PackedVertex> vertices;
+    std::vector<uint16_t> indices;    // level-local, drawn with the level's baseVertex
+    float hysteresis;              // fraction of a threshold to overshoot before switching
+
+    SphereLOD(float hysteresis = 0.15f) : hysteresis(hysteresis) {
+        addLevel(8, 16, 0.0f);
+        addLevel(16, 32, 6.0f);
+        addLevel(32, 64, 24.0f);
+        addLevel(64, 128, 80.0f);
+        addLevel(128, 256, 240.0f);
+    }
+
+    // level for a sphere covering screenRadius pixels, given the level it used last frame
+    int select(float screenRadius, int current) const {
+        int target = 0;
+        for (int i = (int)levels.size() - 1; i > 0; i--) {
+            if (screenRadius >= levels[i].minPixels) {
+                target = i;
+                break;
+            }
+        }
+        if (current < 0 || current >= (int)levels.size() || target == current)
+            return target;
+
+        // moving up must clear the next threshold, moving down must fall below the current one
+        if (target > current && screenRadius < levels[current + 1].minPixels * (1.0f + hysteresis))
+            return current;
+        if (target < current && screenRadius > levels[current].minPixels * (1.0f - hysteresis))
+            return current;
+        return target;
+    }
+
+    unsigned int triangleCount(int level) const { return levels[level].indexCount / 3; }
+
+private:
+    void addLevel(unsigned int rings, unsigned int sectors, float minPixels) {
+        Sphere sphere(1.0f, rings, sectors);
+
+        Level level;
+        level.rings = rings;
+        level.sectors = sectors;
+        level.minPixels = minPixels;
+        level.firstIndex = (unsigned int)indices.size();
+        level.indexCount = (unsigned int)sphere.indices.size();
+        level.baseVertex = (int)vertices.size();
+        level.acmrBefore = sphere.acmrBefore;
+        level.acmrAfter = sphere.acmrAfter;
+
+        std::vector<PackedVertex> packed = packVertices(sphere.vertices);
+        vertices.insert(vertices.end(), packed.begin(), packed.end());
+        indices.insert(indices.end(), sphere.indices.begin(), sphere.indices.end());
+        levels.push_back(level);
+    }
+};
+
+#endif
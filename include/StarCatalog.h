@@ -0,0 +1,270 @@
+#ifndef STAR_CATALOG_H
+#define STAR_CATALOG_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "FrustumCuller.h"
+
+// Background stars from a binary catalog: direction, visual magnitude and B-V color index
+// per star. Stars are sorted into sky cells (a CELLS x CELLS grid on each cube face) and,
+// inside a cell, brightest first, so "every star brighter than m in this cell" is a prefix
+// of the cell's range. A frame draws one prefix per cell in the view with glMultiDrawArrays;
+// the limiting magnitude follows the zoom like a telescope would, and is pulled back whenever
+// the view would hold more than the star budget, so the cost stays flat however big the
+// catalog is and faint stars (1-2 pixel sprites) never flood the screen.
+//
+// Catalog file, little endian: "STAR", uint32 version (1), uint32 count, then count records
+// of float x, y, z (unit direction in scene coordinates, y = ecliptic north), float magnitude,
+// float colorIndex. Hipparcos or Tycho converted to ecliptic directions fits straight in;
+// without a file a synthetic sky with the same statistics is generated.
+class StarCatalog {
+public:
+    static const int CELLS = 16;               // per cube face edge
+    static const int CELL_COUNT = 6 * CELLS * CELLS;
+    static const uint32_t FILE_VERSION = 1;
+
+    float limitMagnitude;    // faintest star at the widest zoom
+    int starBudget;          // most stars drawn in one frame
+
+    StarCatalog() : limitMagnitude(6.5f), starBudget(100000), VAO(0), VBO(0), frameLimit(0.0f), drawnStars(0) {}
+
+    void init(const std::string& path) {
+        std::vector<Star> stars;
+        if (!loadFile(path, stars)) {
+            generate(150000, stars);
+            std::cout << "Star catalog not found (" << path << "), generated " << stars.size() << " stars" << std::endl;
+        } else {
+            std::cout << "Star catalog loaded: " << path << " (" << stars.size() << " stars)" << std::endl;
+        }
+
+        // cell, then brightest first
+        for (auto& s : stars)
+            s.cell = cellOf(glm::vec3(s.x, s.y, s.z));
+        std::sort(stars.begin(), stars.end(), [](const Star& a, const Star& b) {
+            return a.cell != b.cell ? a.cell < b.cell : a.magnitude < b.magnitude;
+        });
+
+        cells.assign(CELL_COUNT, Cell());
+        magnitudes.resize(stars.size());
+        std::vector<float> vertices;
+        vertices.reserve(stars.size() * 5);
+        for (size_t i = 0; i < stars.size(); i++) {
+            const Star& s = stars[i];
+            Cell& cell = cells[s.cell];
+            if (cell.count == 0)
+                cell.first = (GLint)i;
+            cell.count++;
+            magnitudes[i] = s.magnitude;
+            vertices.insert(vertices.end(), { s.x, s.y, s.z, s.magnitude, s.colorIndex });
+        }
+        for (int c = 0; c < CELL_COUNT; c++)
+            cellBounds(c, cells[c].center, cells[c].radius);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+    }
+
+    void destroy() {
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            VAO = VBO = 0;
+        }
+    }
+
+    // picks this frame's cells and limiting magnitude; skyFrustum comes from the projection
+    // times the view's rotation only, the stars being infinitely far away
+    void update(const Frustum& skyFrustum, float fovDegrees) {
+        visible.clear();
+        for (int c = 0; c < CELL_COUNT; c++) {
+            if (cells[c].count > 0 && skyFrustum.containsSphere(cells[c].center, cells[c].radius))
+                visible.push_back(c);
+        }
+
+        // narrower view, fainter stars: magnitudes are 2.5 log10 of brightness, zoom gathers light with the area
+        frameLimit = limitMagnitude + 5.0f * log10f(45.0f / fovDegrees);
+        while (countBrighter(frameLimit) > (size_t)starBudget && frameLimit > -2.0f)
+            frameLimit -= 0.25f;
+
+        firsts.clear();
+        counts.clear();
+        drawnStars = 0;
+        for (int c : visible) {
+            GLsizei count = brighterIn(c, frameLimit);
+            if (count == 0)
+                continue;
+            firsts.push_back(cells[c].first);
+            counts.push_back(count);
+            drawnStars += count;
+        }
+    }
+
+    // one multi-draw of point sprites; the caller has the star program bound
+    void draw() const {
+        if (firsts.empty())
+            return;
+        glBindVertexArray(VAO);
+        glMultiDrawArrays(GL_POINTS, firsts.data(), counts.data(), (GLsizei)firsts.size());
+    }
+
+    float getFrameLimit() const { return frameLimit; }
+    size_t getDrawnStars() const { return drawnStars; }
+    size_t getStarCount() const { return magnitudes.size(); }
+    size_t getVisibleCells() const { return visible.size(); }
+
+private:
+    struct Star {
+        float x, y, z;
+        float magnitude;
+        float colorIndex;
+        int cell;
+    };
+
+    struct Cell {
+        GLint first = 0;
+        GLsizei count = 0;
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;   // sine of the angle to the farthest corner, see update()
+    };
+
+    GLuint VAO, VBO;
+    std::vector<Cell> cells;
+    std::vector<float> magnitudes;   // same order as the vertex buffer
+    std::vector<int> visible;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    float frameLimit;
+    size_t drawnStars;
+
+    GLsizei brighterIn(int c, float limit) const {
+        const float* begin = magnitudes.data() + cells[c].first;
+        return (GLsizei)(std::upper_bound(begin, begin + cells[c].count, limit) - begin);
+    }
+
+    size_t countBrighter(float limit) const {
+        size_t total = 0;
+        for (int c : visible)
+            total += brighterIn(c, limit);
+        return total;
+    }
+
+    static glm::vec3 facePoint(int face, float a, float b) {
+        switch (face) {
+            case 0: return glm::vec3(1.0f, b, -a);
+            case 1: return glm::vec3(-1.0f, b, a);
+            case 2: return glm::vec3(a, 1.0f, -b);
+            case 3: return glm::vec3(a, -1.0f, b);
+            case 4: return glm::vec3(a, b, 1.0f);
+            default: return glm::vec3(-a, b, -1.0f);
+        }
+    }
+
+    static int cellOf(const glm::vec3& d) {
+        glm::vec3 m = glm::abs(d);
+        int face;
+        float a, b;
+        if (m.x >= m.y && m.x >= m.z) {
+            face = d.x > 0.0f ? 0 : 1;
+            a = (d.x > 0.0f ? -d.z : d.z) / m.x;
+            b = d.y / m.x;
+        } else if (m.y >= m.z) {
+            face = d.y > 0.0f ? 2 : 3;
+            a = d.x / m.y;
+            b = (d.y > 0.0f ? -d.z : d.z) / m.y;
+        } else {
+            face = d.z > 0.0f ? 4 : 5;
+            a = (d.z > 0.0f ? d.x : -d.x) / m.z;
+            b = d.y / m.z;
+        }
+        int i = std::min((int)((a * 0.5f + 0.5f) * CELLS), CELLS - 1);
+        int j = std::min((int)((b * 0.5f + 0.5f) * CELLS), CELLS - 1);
+        return (face * CELLS + j) * CELLS + i;
+    }
+
+    // unit center direction and a radius that makes Frustum::containsSphere a cone test
+    static void cellBounds(int c, glm::vec3& center, float& radius) {
+        int face = c / (CELLS * CELLS);
+        int j = (c / CELLS) % CELLS, i = c % CELLS;
+        float step = 2.0f / CELLS;
+        float a0 = -1.0f + i * step, b0 = -1.0f + j * step;
+        center = glm::normalize(facePoint(face, a0 + step * 0.5f, b0 + step * 0.5f));
+        float minCos = 1.0f;
+        for (int k = 0; k < 4; k++) {
+            glm::vec3 corner = glm::normalize(facePoint(face, a0 + (k & 1) * step, b0 + (k >> 1) * step));
+            minCos = std::min(minCos, glm::dot(center, corner));
+        }
+        radius = std::sqrt(std::max(0.0f, 1.0f - minCos * minCos)) + 1e-3f;
+    }
+
+    static bool loadFile(const std::string& path, std::vector<Star>& stars) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[4];
+        uint32_t version = 0, count = 0;
+        if (!file || !file.read(magic, 4) || std::memcmp(magic, "STAR", 4) != 0)
+            return false;
+        if (!file.read((char*)&version, sizeof(version)) || version != FILE_VERSION ||
+            !file.read((char*)&count, sizeof(count)))
+            return false;
+
+        std::vector<float> records((size_t)count * 5);
+        if (!file.read((char*)records.data(), records.size() * sizeof(float)))
+            return false;
+        stars.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const float* r = &records[(size_t)i * 5];
+            glm::vec3 dir = glm::normalize(glm::vec3(r[0], r[1], r[2]));
+            stars[i] = { dir.x, dir.y, dir.z, r[3], r[4], 0 };
+        }
+        return true;
+    }
+
+    // stand-in sky: counts per magnitude as in the real one (about 4500 stars to 6.5, 10x per
+    // 2.2 magnitudes fainter), faint stars crowding a milky way tilted 60 degrees to the ecliptic
+    static void generate(size_t count, std::vector<Star>& stars) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::normal_distribution<float> color(0.6f, 0.35f);
+        float tilt = glm::radians(60.0f);
+
+        stars.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            // cumulative count N(< m) = 4.4 * 10^(0.46 m)
+            float magnitude = log10f((i + 1) / 4.4f) / 0.46f;
+
+            float sinLatitude;
+            if (magnitude < 4.0f || uniform(rng) < 0.45f) {
+                sinLatitude = uniform(rng) * 2.0f - 1.0f;
+            } else {
+                sinLatitude = std::min(-logf(1.0f - uniform(rng) * 0.999f) * 0.12f, 1.0f);
+                if (uniform(rng) < 0.5f)
+                    sinLatitude = -sinLatitude;
+            }
+            float longitude = uniform(rng) * 6.28318531f;
+            float cosLatitude = std::sqrt(1.0f - sinLatitude * sinLatitude);
+            glm::vec3 galactic(cosLatitude * cosf(longitude), sinLatitude, cosLatitude * sinf(longitude));
+            glm::vec3 dir(galactic.x, galactic.y * cosf(tilt) - galactic.z * sinf(tilt),
+                          galactic.y * sinf(tilt) + galactic.z * cosf(tilt));
+
+            stars[i] = { dir.x, dir.y, dir.z, magnitude, glm::clamp(color(rng), -0.3f, 2.0f), 0 };
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "stb_image.h"
+
+// Packs surface maps into one GL_TEXTURE_2D_ARRAY so draws never rebind textures.
+// All layers share the size most of the maps have; odd ones (earth.jpg is 2000x1000)
+// are resampled bilinearly to it. Layers are looked up by name after build().
+class TextureManager {
+public:
+    TextureManager() : textureID(0), layerWidth(0), layerHeight(0) {}
+
+    // queue a map, loaded by build()
+    void add(const std::string& name, const std::string& path) {
+        pending.push_back({ name, path });
+    }
+
+    // loads every queued map, returns the number of layers created
+    int build() {
+        std::vector<Image> images;
+        std::map<std::pair<int, int>, int> sizeVotes;
+
+        stbi_set_flip_vertically_on_load(true);
+        for (const auto& entry : pending) {
+            Image image;
+            int channels;
+            image.name = entry.name;
+            image.path = entry.path;
+            image.pixels = stbi_load(entry.path.c_str(), &image.width, &image.height, &channels, 3);
+            if (!image.pixels) {
+                std::cout << "Texture failed to load: " << entry.path << std::endl;
+                continue;
+            }
+            sizeVotes[{ image.width, image.height }]++;
+            images.push_back(image);
+        }
+        pending.clear();
+        if (images.empty())
+            return 0;
+
+        // most common size wins, ties go to the larger one
+        int bestVotes = 0;
+        for (const auto& vote : sizeVotes) {
+            if (vote.second >= bestVotes) {
+                bestVotes = vote.second;
+                layerWidth = vote.first.first;
+                layerHeight = vote.first.second;
+            }
+        }
+
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, layerWidth, layerHeight, (GLsizei)images.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        std::vector<unsigned char> resampled;
+        for (size_t i = 0; i < images.size(); i++) {
+            Image& image = images[i];
+            const unsigned char* pixels = image.pixels;
+            if (image.width != layerWidth || image.height != layerHeight) {
+                resample(image, resampled);
+                pixels = resampled.data();
+                std::cout << "Texture resampled: " << image.path << " (" << image.width << "x" << image.height
+                          << " -> " << layerWidth << "x" << layerHeight << ")" << std::endl;
+            }
+
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i, layerWidth, layerHeight, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+            stbi_image_free(image.pixels);
+
+            layers[image.name] = (int)i;
+            std::cout << "Texture loaded: " << image.path << " (layer " << i << ")" << std::endl;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        return (int)images.size();
+    }
+
+    // layer index for a map, -1 if it wasn't loaded
+    int layer(const std::string& name) const {
+        auto it = layers.find(name);
+        return it != layers.end() ? it->second : -1;
+    }
+
+    void bind(GLenum unit) const {
+        glActiveTexture(unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    }
+
+    void destroy() {
+        if (textureID != 0) {
+            glDeleteTextures(1, &textureID);
+            textureID = 0;
+        }
+    }
+
+    GLuint getID() const { return textureID; }
+    int getLayerCount() const { return (int)layers.size(); }
+    int getLayerWidth() const { return layerWidth; }
+    int getLayerHeight() const { return layerHeight; }
+
+private:
+    struct Entry {
+        std::string name;
+        std::string path;
+    };
+
+    struct Image {
+        std::string name;
+        std::string path;
+        int width, height;
+        unsigned char* pixels;
+    };
+
+    GLuint textureID;
+    int layerWidth, layerHeight;
+    std::vector<Entry> pending;
+    std::map<std::string, int> layers;
+
+    // bilinear, u wraps around (equirectangular maps), v clamps at the poles
+    void resample(const Image& image, std::vector<unsigned char>& out) const {
+        out.resize((size_t)layerWidth * layerHeight * 3);
+        float scaleX = (float)image.width / layerWidth;
+        float scaleY = (float)image.height / layerHeight;
+
+        for (int y = 0; y < layerHeight; y++) {
+            float sy = (y + 0.5f) * scaleY - 0.5f;
+            if (sy < 0.0f) sy = 0.0f;
+            int y0 = (int)sy;
+            int y1 = y0 + 1 < image.height ? y0 + 1 : image.height - 1;
+            float fy = sy - y0;
+
+            for (int x = 0; x < layerWidth; x++) {
+                float sx = (x + 0.5f) * scaleX - 0.5f;
+                if (sx < 0.0f) sx += image.width;
+                int x0 = (int)sx % image.width;
+                int x1 = (x0 + 1) % image.width;
+                float fx = sx - (int)sx;
+
+                const unsigned char* p00 = &image.pixels[((size_t)y0 * image.width + x0) * 3];
+                const unsigned char* p10 = &image.pixels[((size_t)y0 * image.width + x1) * 3];
+                const unsigned char* p01 = &image.pixels[((size_t)y1 * image.width + x0) * 3];
+                const unsigned char* p11 = &image.pixels[((size_t)y1 * image.width + x1) * 3];
+                unsigned char* dst = &out[((size_t)y * layerWidth + x) * 3];
+
+                for (int c = 0; c < 3; c++) {
+                    float top = p00[c] + (p10[c] - p00[c]) * fx;
+                    float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+                    dst[c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef TRAIL_RENDERER_H
+#define TRAIL_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+
+// Traversed-path trails for moving bodies.
+// All trails share one VBO. Each trail owns a ring buffer of `capacity` points that is
+// stored twice back to back, so the newest `count` points are always one contiguous
+// range and every trail is a single line strip in one glMultiDrawArrays call.
+// Writes go to a CPU shadow copy; upload() sends the vertices written since the last call
+// (the live head, plus the new head on commit) once per frame, neighbouring ones merged
+// into a single glBufferSubData.
+class TrailRenderer {
+public:
+    static const unsigned int MERGE_GAP = 64;   // clean vertices re-sent rather than starting another upload
+
+    float spacing;   // distance travelled before the head point is committed
+
+    TrailRenderer(float spacing = 1.0f) : spacing(spacing), VAO(0), VBO(0), totalVertices(0) {}
+
+    // one entry per body, 0 disables the trail
+    void init(const std::vector<unsigned int>& capacities) {
+        trails.resize(capacities.size());
+        for (size_t i = 0; i < trails.size(); i++) {
+            trails[i] = Trail();
+            trails[i].capacity = capacities[i] >= 2 ? capacities[i] : 0;
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        layout();
+    }
+
+    void destroy() {
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            VAO = 0;
+        }
+    }
+
+    unsigned int getCapacity(size_t index) const { return trails[index].capacity; }
+    unsigned int getTotalVertices() const { return totalVertices; }
+
+    // changes one trail's length, keeping the newest points of every trail
+    void setCapacity(size_t index, unsigned int capacity) {
+        capacity = capacity >= 2 ? capacity : 0;
+        if (trails[index].capacity == capacity)
+            return;
+
+        // pull the current history out of the shadow copy
+        std::vector<std::vector<float>> history(trails.size());
+        for (size_t i = 0; i < trails.size(); i++) {
+            const Trail& t = trails[i];
+            unsigned int start = (t.head + t.capacity + 1 - t.count) % std::max(t.capacity, 1u);
+            history[i].assign(shadow.begin() + (t.first + start) * 6,
+                              shadow.begin() + (t.first + start + t.count) * 6);
+        }
+
+        trails[index].capacity = capacity;
+        layout();
+
+        // write back as much as fits
+        for (size_t i = 0; i < trails.size(); i++) {
+            Trail& t = trails[i];
+            unsigned int keep = std::min((unsigned int)(history[i].size() / 6), t.capacity);
+            if (keep == 0)
+                continue;
+            const float* src = &history[i][history[i].size() - keep * 6];
+            for (unsigned int p = 0; p < keep; p++) {
+                writeShadow(t, p, src + p * 6);
+            }
+            t.count = keep;
+            t.head = keep - 1;
+            t.anchor = glm::vec3(src[(keep - 1) * 6], src[(keep - 1) * 6 + 1], src[(keep - 1) * 6 + 2]);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, shadow.size() * sizeof(float), shadow.data());
+        dirty.clear();
+    }
+
+    // once per frame after the appends
+    void upload() {
+        if (dirty.empty())
+            return;
+        std::sort(dirty.begin(), dirty.end());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        unsigned int begin = dirty[0], end = dirty[0] + 1;
+        for (size_t i = 1; i <= dirty.size(); i++) {
+            if (i < dirty.size() && dirty[i] <= end + MERGE_GAP) {
+                end = std::max(end, dirty[i] + 1);
+                continue;
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, begin * 6 * sizeof(float), (end - begin) * 6 * sizeof(float), &shadow[begin * 6]);
+            if (i < dirty.size()) {
+                begin = dirty[i];
+                end = begin + 1;
+            }
+        }
+        dirty.clear();
+    }
+
+    // call once per frame per body
+    void append(size_t index, const glm::vec3& position, const glm::vec3& color) {
+        Trail& t = trails[index];
+        if (t.capacity == 0)
+            return;
+
+        float vertex[6] = { position.x, position.y, position.z, color.r, color.g, color.b };
+
+        if (t.count == 0) {
+            // first committed point plus the live head
+            t.head = 0;
+            writeVertex(t, 0, vertex);
+            t.head = 1;
+            t.count = 2;
+            t.anchor = position;
+            writeVertex(t, t.head, vertex);
+            return;
+        }
+
+        // the live head always follows the body
+        writeVertex(t, t.head, vertex);
+
+        // far enough from the last committed point - keep it and open a new head
+        if (glm::length(position - t.anchor) >= spacing) {
+            t.anchor = position;
+            t.head = (t.head + 1) % t.capacity;
+            t.count = std::min(t.count + 1, t.capacity);
+            writeVertex(t, t.head, vertex);
+        }
+    }
+
+    void clear() {
+        for (auto& t : trails) {
+            t.count = 0;
+            t.head = 0;
+        }
+    }
+
+    // all trails in one call
+    void draw() {
+        drawFirsts.clear();
+        drawCounts.clear();
+        for (const auto& t : trails) {
+            if (t.count < 2)
+                continue;
+            unsigned int start = (t.head + t.capacity + 1 - t.count) % t.capacity;
+            drawFirsts.push_back((GLint)(t.first + start));
+            drawCounts.push_back((GLsizei)t.count);
+        }
+        if (drawFirsts.empty())
+            return;
+
+        glBindVertexArray(VAO);
+        glMultiDrawArrays(GL_LINE_STRIP, drawFirsts.data(), drawCounts.data(), (GLsizei)drawFirsts.size());
+        glBindVertexArray(0);
+    }
+
+private:
+    struct Trail {
+        unsigned int first = 0;      // first vertex in the shared buffer
+        unsigned int capacity = 0;   // ring size, the buffer holds 2 * capacity
+        unsigned int head = 0;       // slot of the live point
+        unsigned int count = 0;      // points in use, including the head
+        glm::vec3 anchor = glm::vec3(0.0f);
+    };
+
+    GLuint VAO, VBO;
+    unsigned int totalVertices;
+    std::vector<Trail> trails;
+    std::vector<float> shadow;          // cpu copy of the whole buffer
+    std::vector<unsigned int> dirty;    // vertices written since the last upload()
+    std::vector<GLint> drawFirsts;
+    std::vector<GLsizei> drawCounts;
+
+    void layout() {
+        totalVertices = 0;
+        for (auto& t : trails) {
+            t.first = totalVertices;
+            t.head = 0;
+            t.count = 0;
+            totalVertices += t.capacity * 2;
+        }
+        shadow.assign(totalVertices * 6, 0.0f);
+        dirty.clear();
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, std::max(totalVertices, 1u) * 6 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+    }
+
+    void writeShadow(const Trail& t, unsigned int slot, const float* vertex) {
+        std::copy(vertex, vertex + 6, shadow.begin() + (t.first + slot) * 6);
+        std::copy(vertex, vertex + 6, shadow.begin() + (t.first + slot + t.capacity) * 6);
+    }
+
+    // writes the slot and its mirror, both sent with the next upload()
+    void writeVertex(const Trail& t, unsigned int slot, const float* vertex) {
+        writeShadow(t, slot, vertex);
+        dirty.push_back(t.first + slot);
+        dirty.push_back(t.first + slot + t.capacity);
+    }
+};
+
+#endif
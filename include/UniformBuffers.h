@@ -0,0 +1,136 @@
+#ifndef UNIFORM_BUFFERS_H
+#define UNIFORM_BUFFERS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <vector>
+
+// binding points shared by every program, see ShaderProgram::reflect
+const GLuint FRAME_DATA_BINDING = 0;
+const GLuint OBJECT_DATA_BINDING = 1;
+
+// std140 layout of the FrameData block, only vec4/mat4 members so no padding surprises
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPos;    // w = time in seconds
+    glm::vec4 lightPos;
+};
+
+// std140 layout of the ObjectData block
+struct ObjectData {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;   // inverse transpose of the upper 3x3, stored as a mat4
+};
+
+// block name -> binding point, -1 for blocks we don't manage
+inline int uniformBlockBinding(const char* name) {
+    if (std::strcmp(name, "FrameData") == 0) return (int)FRAME_DATA_BINDING;
+    if (std::strcmp(name, "ObjectData") == 0) return (int)OBJECT_DATA_BINDING;
+    return -1;
+}
+
+// Camera, light and time for the whole frame, one glBufferSubData per frame.
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer() : UBO(0) {}
+
+    void init() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void update(const FrameData& data) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void destroy() {
+        if (UBO != 0) {
+            glDeleteBuffers(1, &UBO);
+            UBO = 0;
+        }
+    }
+
+private:
+    GLuint UBO;
+};
+
+// Per-object model and normal matrices for a frame.
+// Objects are added up front, the whole array goes up in one call, and draws
+// select their slot with glBindBufferRange.
+class ObjectUniformBuffer {
+public:
+    ObjectUniformBuffer() : UBO(0), stride(0), capacity(0), count(0) {}
+
+    void init(unsigned int initialCapacity = 64) {
+        // ranges must start on the driver's offset alignment
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (unsigned int)sizeof(ObjectData);
+        if (alignment > 0)
+            stride = (stride + alignment - 1) / alignment * alignment;
+
+        glGenBuffers(1, &UBO);
+        reserve(initialCapacity);
+    }
+
+    void destroy() {
+        if (UBO != 0) {
+            glDeleteBuffers(1, &UBO);
+            UBO = 0;
+        }
+    }
+
+    void begin() { count = 0; }
+
+    // returns the slot to bind when drawing this object
+    int add(const glm::mat4& model) {
+        if (count == capacity)
+            reserve(capacity * 2);
+
+        ObjectData data;
+        data.model = model;
+        data.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+        std::memcpy(&staging[count * stride], &data, sizeof(ObjectData));
+        return (int)count++;
+    }
+
+    // one upload for every object added this frame
+    void upload() {
+        if (count == 0)
+            return;
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, capacity * stride, NULL, GL_DYNAMIC_DRAW);   // orphan last frame's copy
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, count * stride, staging.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void bind(int slot) const {
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_DATA_BINDING, UBO, (GLintptr)slot * stride, sizeof(ObjectData));
+    }
+
+    unsigned int getCount() const { return count; }
+
+private:
+    GLuint UBO;
+    unsigned int stride;
+    unsigned int capacity;
+    unsigned int count;
+    std::vector<unsigned char> staging;
+
+    void reserve(unsigned int newCapacity) {
+        capacity = newCapacity > 0 ? newCapacity : 1;
+        staging.resize(capacity * stride);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, capacity * stride, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 sourceScale;   // part of the source in use (dynamic resolution)
+uniform bool prefilter;     // first pass: keep only what is brighter than the threshold
+uniform float threshold;
+uniform float knee;         // soft transition below the threshold
+
+// dual filter downsample (Bjorge, SIGGRAPH 2015): center plus four bilinear taps
+// half a source texel out, each tap already averaging four texels
+vec2 halfPixel;
+
+// taps past the used part would pick up stale texels, clamp them to its edge
+vec3 tap(vec2 uv)
+{
+    return texture(source, min(uv, sourceScale - halfPixel)).rgb;
+}
+
+vec3 sampleBox(vec2 uv)
+{
+    halfPixel = 0.5 / vec2(textureSize(source, 0));
+    vec3 sum = tap(uv) * 4.0;
+    sum += tap(uv - halfPixel);
+    sum += tap(uv + halfPixel);
+    sum += tap(uv + vec2(halfPixel.x, -halfPixel.y));
+    sum += tap(uv - vec2(halfPixel.x, -halfPixel.y));
+    return sum / 8.0;
+}
+
+void main()
+{
+    vec3 color = sampleBox(TexCoords * sourceScale);
+    
+    if (prefilter) {
+        float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+        float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+        soft = soft * soft / (4.0 * knee + 1e-5);
+        color *= max(soft, brightness - threshold) / max(brightness, 1e-5);
+    }
+    
+    FragColor = vec4(color, 1.0);
+}
@@ -5,16 +5,21 @@ in vec2 TexCoords;
 
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
-uniform float bloom;
+uniform float bloom;         // strength of the glow added on top
 uniform float exposure;
+// the scene and glow fill only this much of their textures when rendered at reduced resolution;
+// stretching them over the window is the upscale
+uniform vec2 sceneScale;
+uniform vec2 bloomScale;
 
 void main()
 {             
-    vec3 hdrColor = texture(scene, TexCoords).rgb;      
-    vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
+    vec2 sceneLimit = sceneScale - 0.5 / vec2(textureSize(scene, 0));
+    vec2 bloomLimit = bloomScale - 0.5 / vec2(textureSize(bloomBlur, 0));
+    vec3 hdrColor = texture(scene, min(TexCoords * sceneScale, sceneLimit)).rgb;
+    vec3 bloomColor = texture(bloomBlur, min(TexCoords * bloomScale, bloomLimit)).rgb;
     
-    if(bloom > 0.5)
-        hdrColor += bloomColor; // additive blending
+    hdrColor += bloomColor * bloom;
     
     // tone mapping
     vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;   // the next smaller level, added onto this one by blending
+uniform vec2 sourceScale;   // part of the source in use (dynamic resolution)
+
+vec2 halfPixel;
+
+vec3 tap(vec2 uv)
+{
+    return texture(source, min(uv, sourceScale - halfPixel)).rgb;
+}
+
+// dual filter upsample: a ring of eight bilinear taps around the pixel, diagonals weighted double
+void main()
+{
+    halfPixel = 0.5 / vec2(textureSize(source, 0));
+    vec2 uv = TexCoords * sourceScale;
+    vec3 sum = tap(uv + vec2(-halfPixel.x * 2.0, 0.0));
+    sum += tap(uv + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+    sum += tap(uv + vec2(0.0, halfPixel.y * 2.0));
+    sum += tap(uv + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+    sum += tap(uv + vec2(halfPixel.x * 2.0, 0.0));
+    sum += tap(uv + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+    sum += tap(uv + vec2(0.0, -halfPixel.y * 2.0));
+    sum += tap(uv + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+    FragColor = vec4(sum / 12.0, 1.0);
+}
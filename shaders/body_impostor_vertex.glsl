@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;    // quad corner in [-1, 1]
+layout (location = 3) in mat4 aModel;     // per instance, uses locations 3-6
+layout (location = 7) in vec4 aColor;     // rgb, surface layer (-1 = untextured)
+layout (location = 8) in vec4 aFlags;     // isSun, isSelected, night lights layer (-1 = none)
+
+out vec3 RayTarget;
+flat out vec4 SphereBounds;     // center, radius
+flat out mat3 Orientation;      // body rotation without the scale
+flat out vec3 ObjectColor;
+flat out float Layer;
+flat out vec3 Flags;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    vec3 center = aModel[3].xyz;
+    float radius = length(aModel[0].xyz);
+    
+    // quad through the center facing the camera, big enough to hold the
+    // silhouette: the tangent cone is wider than the radius up close
+    vec3 toCamera = viewPos.xyz - center;
+    float distance = max(length(toCamera), radius * 1.01);
+    vec3 forward = toCamera / length(toCamera);
+    vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(up, forward));
+    up = cross(forward, right);
+    float halfSize = radius * distance / sqrt(distance * distance - radius * radius);
+    
+    RayTarget = center + (right * aCorner.x + up * aCorner.y) * halfSize;
+    SphereBounds = vec4(center, radius);
+    Orientation = mat3(aModel) / radius;
+    ObjectColor = aColor.rgb;
+    Layer = aColor.a;
+    Flags = aFlags.xyz;
+    gl_Position = projection * view * vec4(RayTarget, 1.0);
+}
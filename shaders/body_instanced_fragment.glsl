@@ -0,0 +1,141 @@
+#version 330 core
+
+layout (location = 0) out vec4 FragColor;
+
+#ifdef IMPOSTOR
+in vec3 RayTarget;
+flat in vec4 SphereBounds;     // center, radius
+flat in mat3 Orientation;
+
+// filled in by traceSphere() instead of being interpolated
+vec3 FragPos;
+vec3 Normal;
+vec2 TexCoord;
+#else
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+#endif
+flat in vec3 ObjectColor;
+flat in float Layer;
+flat in vec3 Flags;
+
+uniform sampler2DArray surfaceTextures;
+uniform float glowIntensity;
+
+#include "frame_data.glsl"
+
+#ifdef IMPOSTOR
+// intersects the camera ray through this pixel with the sphere, writes the depth of the hit
+// and fills in what the mesh path interpolates; the uv matches Sphere.h's parameterization
+bool traceSphere()
+{
+    vec3 origin = viewPos.xyz;
+    vec3 dir = normalize(RayTarget - origin);
+    vec3 oc = origin - SphereBounds.xyz;
+    float b = dot(oc, dir);
+    float h = b * b - dot(oc, oc) + SphereBounds.w * SphereBounds.w;
+    
+    // misses still get a point on the silhouette so neighbouring derivatives stay sane
+    float t = -b - sqrt(max(h, 0.0));
+    FragPos = origin + dir * t;
+    Normal = (FragPos - SphereBounds.xyz) / SphereBounds.w;
+    
+    vec3 local = normalize(transpose(Orientation) * Normal);
+    float s = atan(local.z, local.x) / 6.28318531;
+    TexCoord = vec2(1.0 - fract(s), acos(clamp(-local.y, -1.0, 1.0)) / 3.14159265);
+    
+    vec4 clip = projection * view * vec4(FragPos, 1.0);
+#ifdef DEPTH_ZERO_TO_ONE
+    // glClipControl: ndc depth is already 0..1
+    gl_FragDepth = gl_DepthRange.diff * (clip.z / clip.w) + gl_DepthRange.near;
+#else
+    gl_FragDepth = 0.5 * (gl_DepthRange.diff * (clip.z / clip.w) + gl_DepthRange.near + gl_DepthRange.far);
+#endif
+    return h >= 0.0;
+}
+#endif
+
+vec3 sampleSurface(float layer)
+{
+#ifdef IMPOSTOR
+    // u jumps from 1 to 0 at the seam; take gradients from whichever of u and u + 0.5
+    // is continuous here so the seam doesn't drop to the coarsest mip
+    vec2 shifted = vec2(fract(TexCoord.x + 0.5), TexCoord.y);
+    vec2 dx = dFdx(TexCoord), dy = dFdy(TexCoord);
+    vec2 dxShifted = dFdx(shifted), dyShifted = dFdy(shifted);
+    if (dot(dxShifted, dxShifted) + dot(dyShifted, dyShifted) < dot(dx, dx) + dot(dy, dy)) {
+        dx = dxShifted;
+        dy = dyShifted;
+    }
+    return textureGrad(surfaceTextures, vec3(TexCoord, layer), dx, dy).rgb;
+#else
+    return texture(surfaceTextures, vec3(TexCoord, layer)).rgb;
+#endif
+}
+
+void main()
+{
+#ifdef IMPOSTOR
+    bool hit = traceSphere();
+#endif
+    bool isSun = Flags.x > 0.5;
+    bool isSelected = Flags.y > 0.5;
+    float nightLayer = Flags.z;
+    
+    vec3 baseColor = ObjectColor;
+    
+    if (Layer >= 0.0) {
+        baseColor = sampleSurface(Layer);
+    }
+    
+    if (isSun) {
+        // sun is self-illuminating with high brightness
+        vec3 sunColor = baseColor * 2.5; // brighter sun
+        FragColor = vec4(sunColor, 1.0);   // over the bloom threshold
+    } else {
+        // ambient lighting
+        float ambientStrength = 0.05;
+        vec3 ambient = ambientStrength * vec3(1.0, 1.0, 1.0);
+        
+        // diffuse lighting
+        vec3 norm = normalize(Normal);
+        vec3 lightDir = normalize(lightPos.xyz - FragPos);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * vec3(1.0, 1.0, 1.0);
+        
+        // specular reflection
+        float specularStrength = 0.1;
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+        vec3 specular = specularStrength * spec * vec3(1.0, 1.0, 1.0);
+        
+        vec3 result = (ambient + diffuse + specular) * baseColor;
+        
+        // night lights for earth (city lights)
+        if (nightLayer >= 0.0) {
+            vec3 nightColor = sampleSurface(nightLayer);
+            // show city lights on night side
+            float nightStrength = 1.0 - smoothstep(-0.1, 0.2, diff);
+            result += nightColor * nightStrength * 0.8;
+        }
+        
+        // rim lighting for selected planet (edge glow)
+        if (isSelected) {
+            vec3 viewDir = normalize(viewPos.xyz - FragPos);
+            vec3 norm = normalize(Normal);
+            float rimAmount = 1.0 - max(dot(viewDir, norm), 0.0);
+            rimAmount = pow(rimAmount, 3.0); // make edges sharper
+            vec3 rimColor = vec3(0.4, 0.6, 1.0) * rimAmount * glowIntensity * 2.0;
+            result += rimColor;
+        }
+        
+        FragColor = vec4(result, 1.0);
+    }
+    
+#ifdef IMPOSTOR
+    if (!hit)
+        discard;
+#endif
+}
@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;        // snorm16, unit sphere (floats for terrain)
+#ifdef TERRAIN
+layout (location = 1) in vec3 aNormal;     // displaced surface, not the sphere normal
+#endif
+layout (location = 2) in vec2 aTexCoord;   // unorm16
+layout (location = 3) in mat4 aModel;     // per instance, uses locations 3-6
+layout (location = 7) in vec4 aColor;     // rgb, surface layer (-1 = untextured)
+layout (location = 8) in vec4 aFlags;     // isSun, isSelected, night lights layer (-1 = none)
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+flat out vec3 ObjectColor;
+flat out float Layer;
+flat out vec3 Flags;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    // on a unit sphere the normal is the position; bodies only rotate and scale
+    // uniformly, so the upper 3x3 works as the normal matrix
+#ifdef TERRAIN
+    Normal = mat3(aModel) * aNormal;
+#else
+    Normal = mat3(aModel) * aPos;
+#endif
+    TexCoord = aTexCoord;
+    ObjectColor = aColor.rgb;
+    Layer = aColor.a;
+    Flags = aFlags.xyz;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
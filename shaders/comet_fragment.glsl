@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+in vec2 Corner;
+in float Age;
+flat in int IsIon;
+
+uniform float intensity;
+
+void main()
+{
+    // soft round falloff
+    float r2 = dot(Corner, Corner);
+    if (r2 > 1.0)
+        discard;
+    float falloff = exp(-4.0 * r2);
+
+    // yellowish dust, blue ion gas
+    vec3 color = IsIon == 1 ? vec3(0.35, 0.55, 1.0) : vec3(1.0, 0.9, 0.7);
+    float fade = (1.0 - Age) * (1.0 - Age);
+
+    // additive blending, alpha is unused
+    FragColor = vec4(color * falloff * fade * intensity, 0.0);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;     // billboard corner in [-1, 1]
+layout (location = 1) in vec4 aParticle;   // world position, normalized age
+
+out vec2 Corner;
+out float Age;
+flat out int IsIon;
+
+#include "frame_data.glsl"
+
+uniform int ionStart;      // instances from here on belong to the ion tail
+uniform float dustSize;
+uniform float ionSize;
+
+void main()
+{
+    IsIon = gl_InstanceID >= ionStart ? 1 : 0;
+    Age = aParticle.w;
+    Corner = aCorner;
+
+    // dust puffs grow as they drift, ion streaks stay thin
+    float size = IsIon == 1 ? ionSize * (0.6 + 0.4 * Age) : dustSize * (0.5 + 1.5 * Age);
+
+    // camera-facing quad
+    vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPos = aParticle.xyz + (right * aCorner.x + up * aCorner.y) * size;
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,8 @@
+// per-frame block shared by every scene shader, pulled in with #include "frame_data.glsl";
+// layout must match struct FrameData in UniformBuffers.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;    // w = time
+    vec4 lightPos;
+};
@@ -1,16 +1,16 @@
 #version 330 core
 out vec4 FragColor;
-out vec4 BrightColor;
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
 
 uniform sampler2D ringTexture;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
 uniform bool useTexture;
 uniform vec3 ringColor;
+uniform float opacity;
+
+#include "frame_data.glsl"
 
 void main()
 {
@@ -26,7 +26,7 @@ void main()
     }
     
     // Simple lighting
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
     vec3 norm = normalize(Normal);
     
     // Diffuse lighting
@@ -36,7 +36,7 @@ void main()
     float ambient = 0.3;
     
     // Calculate distance-based attenuation
-    float distance = length(lightPos - FragPos);
+    float distance = length(lightPos.xyz - FragPos);
     float attenuation = 1.0 / (1.0 + 0.0001 * distance + 0.000001 * distance * distance);
     
     // Combine lighting
@@ -46,8 +46,5 @@ void main()
     // Apply lighting to texture color
     vec3 result = texColor.rgb * lighting;
     
-    FragColor = vec4(result, texColor.a);
-    
-    // No bloom for rings
-    BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    FragColor = vec4(result, texColor.a * opacity);
 }
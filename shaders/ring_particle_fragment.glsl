@@ -0,0 +1,40 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in float RadialCoord;
+in float Brightness;
+
+uniform sampler2D ringTexture;
+uniform bool useTexture;
+uniform vec3 ringColor;
+
+#include "frame_data.glsl"
+
+void main()
+{
+    // round particles
+    vec2 coord = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(coord, coord);
+    if (r2 > 1.0)
+        discard;
+
+    // same radial color as the ring mesh
+    vec3 baseColor = ringColor;
+    if (useTexture) {
+        baseColor = texture(ringTexture, vec2(RadialCoord, 0.5)).rgb;
+    }
+
+    // same lighting as the ring mesh, lit from either side of the ring plane
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
+    float diff = abs(dot(normalize(Normal), lightDir));
+    float distance = length(lightPos.xyz - FragPos);
+    float attenuation = 1.0 / (1.0 + 0.0001 * distance + 0.000001 * distance * distance);
+    float lighting = clamp(0.3 + diff * attenuation, 0.2, 1.0);
+
+    // darken towards the particle edge so it reads as a small body
+    float shade = 1.0 - 0.5 * r2;
+
+    FragColor = vec4(baseColor * lighting * shade * Brightness, 1.0);
+}
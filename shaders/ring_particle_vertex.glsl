@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec4 aOrbit;   // radius, height, size, brightness
+layout (location = 1) in float aAngle;
+
+out vec3 FragPos;
+out vec3 Normal;
+out float RadialCoord;
+out float Brightness;
+
+#include "frame_data.glsl"
+
+layout (std140) uniform ObjectData {
+    mat4 model;
+    mat4 normalMatrix;   // precomputed inverse transpose
+};
+
+uniform float innerRadius;
+uniform float outerRadius;
+uniform float pointScale;   // converts view-space size to pixels
+
+void main()
+{
+    vec3 localPos = vec3(aOrbit.x * cos(aAngle), aOrbit.y, aOrbit.x * sin(aAngle));
+    FragPos = vec3(model * vec4(localPos, 1.0));
+    Normal = mat3(normalMatrix) * vec3(0.0, 1.0, 0.0);
+    RadialCoord = (aOrbit.x - innerRadius) / (outerRadius - innerRadius);
+    Brightness = aOrbit.w;
+
+    vec4 eyePos = view * vec4(FragPos, 1.0);
+    gl_Position = projection * eyePos;
+    gl_PointSize = clamp(aOrbit.z * pointScale / max(-eyePos.z, 0.001), 1.0, 16.0);
+}
@@ -1,20 +1,31 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoord;
+layout (location = 0) in vec3 aPos;        // snorm16, unit outer radius
+layout (location = 2) in vec2 aTexCoord;   // unorm16
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame_data.glsl"
+
+#ifdef INDIRECT_DRAW
+layout (location = 3) in mat4 aModel;   // per draw, picked by the command's baseInstance
+#else
+layout (std140) uniform ObjectData {
+    mat4 model;
+    mat4 normalMatrix;   // precomputed inverse transpose
+};
+#endif
 
 void main()
 {
+#ifdef INDIRECT_DRAW
+    // orbit lines and rings only rotate and scale uniformly
+    mat4 model = aModel;
+    mat3 normalMatrix = mat3(aModel);
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(normalMatrix) * vec3(0.0, 1.0, 0.0);   // flat ring in the xz plane
     TexCoord = aTexCoord;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+in vec3 StarColor;
+
+void main()
+{
+    // soft round sprite, added onto the sky
+    vec2 coord = gl_PointCoord * 2.0 - 1.0;
+    float falloff = exp(-3.0 * dot(coord, coord));
+    FragColor = vec4(StarColor * falloff, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aDirection;
+layout (location = 1) in vec2 aStar;   // visual magnitude, B-V color index
+
+out vec3 StarColor;
+
+#include "frame_data.glsl"
+
+uniform float limitMagnitude;   // faintest star drawn this frame
+uniform float pointScale;       // sprite size multiplier (render resolution)
+
+// B-V to a blackbody-ish tint: blue-white hot stars through white to orange-red cool ones
+vec3 colorFromIndex(float bv)
+{
+    vec3 hot = vec3(0.64, 0.73, 1.0);
+    vec3 white = vec3(1.0, 0.97, 0.92);
+    vec3 cool = vec3(1.0, 0.62, 0.38);
+    return bv < 0.6 ? mix(hot, white, clamp((bv + 0.3) / 0.9, 0.0, 1.0))
+                    : mix(white, cool, clamp((bv - 0.6) / 1.4, 0.0, 1.0));
+}
+
+void main()
+{
+    // infinitely far away: rotation only
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aDirection, 1.0);
+    gl_Position = pos.xyww;   // drawn without depth test, like the sky
+
+    // magnitudes below the limit, each one ~2.5x brighter; bright stars grow a little
+    // instead of saturating, the last magnitude fades in so a moving limit doesn't pop
+    float above = limitMagnitude - aStar.x;
+    float fade = clamp(above, 0.0, 1.0);
+    float intensity = min(0.25 * pow(2.512, min(above, 6.0) * 0.5), 4.0);
+    StarColor = colorFromIndex(aStar.y) * intensity * fade;
+    gl_PointSize = clamp((1.0 + above * 0.35) * pointScale, 1.0, 7.0);
+}
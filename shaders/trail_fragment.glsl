@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+in vec3 TrailColor;
+
+uniform float brightness;
+
+void main()
+{
+    FragColor = vec4(TrailColor * brightness, 1.0);
+}
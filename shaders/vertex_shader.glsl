@@ -8,14 +8,26 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame_data.glsl"
+
+#ifdef INDIRECT_DRAW
+layout (location = 3) in mat4 aModel;   // per draw, picked by the command's baseInstance
+#else
+layout (std140) uniform ObjectData {
+    mat4 model;
+    mat4 normalMatrix;   // precomputed inverse transpose
+};
+#endif
 
 void main()
 {
+#ifdef INDIRECT_DRAW
+    // orbit lines and rings only rotate and scale uniformly
+    mat4 model = aModel;
+    mat3 normalMatrix = mat3(aModel);
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(normalMatrix) * aNormal;
     TexCoord = aTexCoord;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -8,10 +8,35 @@
 #include <sstream>
 #include <vector>
 #include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <thread>
 #include "Camera.h"
 #include "Sphere.h"
 #include "Ring.h"
 #include "CelestialBody.h"
+#include "RingParticles.h"
+#include "Comet.h"
+#include "SpatialHash.h"
+#include "TrailRenderer.h"
+#include "ShaderProgram.h"
+#include "SphereLOD.h"
+#include "BodyInstances.h"
+#include "AsteroidBelt.h"
+#include "TextureManager.h"
+#include "IndirectRenderer.h"
+#include "FrustumCuller.h"
+#include "BloomChain.h"
+#include "GpuTimer.h"
+#include "DynamicResolution.h"
+#include "RenderTargetPool.h"
+#include "FrameGraph.h"
+#include "OcclusionQueries.h"
+#include "ReversedZ.h"
+#include "Skybox.h"
+#include "StarCatalog.h"
+#include "PlanetTerrain.h"
+#include "ProgramCache.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -26,6 +51,26 @@
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
 
+// framebuffer size, follows the window (the constants above are only the size asked for)
+int screenWidth = SCR_WIDTH;
+int screenHeight = SCR_HEIGHT;
+bool screenResized = false;
+
+// switch saturn's ring to particles closer than this (in saturn radii)
+const float RING_PARTICLE_DISTANCE = 6.0f;
+
+// depth range: near never goes past this, it only shrinks towards surfaces
+const float MAX_NEAR = 0.1f;
+
+// distance a body travels between committed trail points
+const float TRAIL_SPACING = 1.0f;
+
+// number of procedurally generated comets
+const int COMET_COUNT = 24;
+
+// rocks in the main belt between mars and jupiter
+const int ASTEROID_COUNT = 1500;
+
 // camera
 Camera camera(glm::vec3(0.0f, 150.0f, 400.0f));
 float lastX = SCR_WIDTH / 2.0f;
@@ -44,19 +89,416 @@ bool showMenu = false;
 int selectedPlanetIndex = -1;
 bool followMode = false;
 bool showOrbits = true;
+bool ringParticlesEnabled = true;
+bool showComets = true;
+bool showTrails = true;
+bool showAsteroids = true;
+bool useIndirectDraw = true;        // only honoured when the context is 4.3+
+bool frustumCulling = true;
+bool occlusionCulling = true;      // skip bodies hidden behind others last frame
+bool sphereLODEnabled = true;
+bool impostorsEnabled = true;
+float impostorPixels = 6.0f;   // bodies smaller than this on screen are ray traced quads
+bool terrainEnabled = true;
+float followDistance = 80.0f;  // scroll in follow mode to descend towards the surface
 glm::vec3 followOffset(0.0f, 20.0f, 50.0f);
+bool adaptiveCameraSpeed = true;
+float cameraSpeedFactor = 1.0f;     // scaled down near planet surfaces
 float glowPulse = 0.0f;
+float bloomStrength = 0.3f;
+float skyBrightness = 1.0f;
 std::vector<CelestialBody*> celestialBodies;  // for global access
+ProgramCache programCache;                    // linked shader binaries from earlier launches
+
+// uniform handles for each program, resolved once after linking
+struct PlanetParams {
+    int objectColor, isSun, useTexture, isSelected;
+
+    void resolve(const ShaderProgram& p) {
+        objectColor = p.param("objectColor");
+        isSun = p.param("isSun");
+        useTexture = p.param("useTexture");
+        isSelected = p.param("isSelected");
+    }
+};
+
+struct BodyParams {
+    int glowIntensity;
+
+    void resolve(const ShaderProgram& p) {
+        glowIntensity = p.param("glowIntensity");
+    }
+};
+
+struct RingParams {
+    int opacity, useTexture, ringColor;
+
+    void resolve(const ShaderProgram& p) {
+        opacity = p.param("opacity");
+        useTexture = p.param("useTexture");
+        ringColor = p.param("ringColor");
+    }
+};
+
+struct RingParticleParams {
+    int innerRadius, outerRadius, pointScale, useTexture, ringColor;
+
+    void resolve(const ShaderProgram& p) {
+        innerRadius = p.param("innerRadius");
+        outerRadius = p.param("outerRadius");
+        pointScale = p.param("pointScale");
+        useTexture = p.param("useTexture");
+        ringColor = p.param("ringColor");
+    }
+};
+
+struct CometParams {
+    int dustSize, ionSize, intensity, ionStart;
+
+    void resolve(const ShaderProgram& p) {
+        dustSize = p.param("dustSize");
+        ionSize = p.param("ionSize");
+        intensity = p.param("intensity");
+        ionStart = p.param("ionStart");
+    }
+};
+
+struct TrailParams {
+    int brightness;
+
+    void resolve(const ShaderProgram& p) {
+        brightness = p.param("brightness");
+    }
+};
+
+struct SkyboxParams {
+    int brightness;
+
+    void resolve(const ShaderProgram& p) {
+        brightness = p.param("brightness");
+    }
+};
+
+struct StarParams {
+    int limitMagnitude, pointScale;
+
+    void resolve(const ShaderProgram& p) {
+        limitMagnitude = p.param("limitMagnitude");
+        pointScale = p.param("pointScale");
+    }
+};
+
+struct BloomParams {
+    int bloom, exposure, sceneScale, bloomScale;
+
+    void resolve(const ShaderProgram& p) {
+        bloom = p.param("bloom");
+        exposure = p.param("exposure");
+        sceneScale = p.param("sceneScale");
+        bloomScale = p.param("bloomScale");
+    }
+};
+
+struct OrbitLine {
+    GLuint VAO, VBO;
+    int vertexCount;
+    float radius;
+};
+
+// What the "scene" frame graph pass draws with, bound by reference every frame; draw() is
+// the pass itself: sky and stars, orbits, trails, bodies, terrain, occlusion tests, rings
+// and comet tails into the HDR targets.
+struct ScenePass {
+    FrameGraph& frameGraph;
+    RenderTargetPool& renderTargets;
+    int sceneColor, sceneDepth;
+    GLuint& hdrFBO;
+    GLuint& hdrColorAttached;
+    GLuint& hdrDepthAttached;
+    unsigned int& hdrAttachedAllocations;
+
+    // this frame
+    int renderWidth, renderHeight;
+    float renderScale, pixelsPerUnit;
+    bool drawIndirect;
+    int terrainBody;
+    bool useRingParticles;
+    glm::vec3 cameraRingLocal;
+
+    ShaderProgram& skyboxProgram;
+    SkyboxParams& skyboxParams;
+    ShaderProgram& starProgram;
+    StarParams& starParams;
+    ShaderProgram& planetProgram;
+    PlanetParams& planetParams;
+    ShaderProgram& planetIndirectProgram;
+    PlanetParams& planetIndirectParams;
+    ShaderProgram& trailProgram;
+    TrailParams& trailParams;
+    ShaderProgram& bodyProgram;
+    BodyParams& bodyParams;
+    ShaderProgram& bodyImpostorProgram;
+    BodyParams& bodyImpostorParams;
+    ShaderProgram& bodyTerrainProgram;
+    BodyParams& bodyTerrainParams;
+    ShaderProgram& ringParticleProgram;
+    RingParticleParams& ringParticleParams;
+    ShaderProgram& ringProgram;
+    RingParams& ringParams;
+    ShaderProgram& ringIndirectProgram;
+    RingParams& ringIndirectParams;
+    ShaderProgram& cometProgram;
+    CometParams& cometParams;
+
+    ObjectUniformBuffer& objectUniforms;
+    int identitySlot, moonOrbitSlot, ringParticleSlot;
+    const std::vector<int>& proxySlots;
+    const std::vector<int>& ringSlots;
+
+    IndirectRenderer& indirect;
+    IndirectRenderer::Batch& sphereBatch;
+    IndirectRenderer::Batch& orbitBatch;
+    IndirectRenderer::Batch& ringBatch;
+
+    const SphereCullList& orbitCull;
+    const SphereCullList& ringCull;
+    const SphereCullList& cometCull;
+    const std::vector<size_t>& ringOwners;
+    const std::vector<size_t>& occlusionTests;
+
+    Skybox& skybox;
+    StarCatalog& starCatalog;
+    const std::vector<OrbitLine>& orbitLines;
+    TrailRenderer& trails;
+    TextureManager& surfaceTextures;
+    BodyInstanceRenderer& bodyInstances;
+    PlanetTerrain& terrain;
+    OcclusionQueries& occlusion;
+    RingParticleSystem& saturnRingParticles;
+    CelestialBody* saturn;
+    GLuint ringVAO;
+    const Ring& ring;
+    std::vector<Comet>& comets;
+    double& cometCpuTime;
+
+    void draw() {
+        GLuint color = frameGraph.getTexture(sceneColor), depth = frameGraph.getTexture(sceneDepth);
+        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+        // same names can still be new textures if the pool deleted and reallocated in between
+        if (hdrColorAttached != color || hdrDepthAttached != depth || hdrAttachedAllocations != renderTargets.getAllocations()) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+            hdrColorAttached = color;
+            hdrDepthAttached = depth;
+            hdrAttachedAllocations = renderTargets.getAllocations();
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "Framebuffer error!" << std::endl;
+        }
+        glViewport(0, 0, renderWidth, renderHeight);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);  // Siyah uzay
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        // sky and catalog stars behind everything: no depth test or writes, the scene
+        // simply draws over them
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        if (skybox.isReady() && skyBrightness > 0.0f) {
+            glUseProgram(skyboxProgram.id);
+            skyboxProgram.set(skyboxParams.brightness, skyBrightness);
+            skybox.draw();
+        }
+        glUseProgram(starProgram.id);
+        starProgram.set(starParams.limitMagnitude, starCatalog.getFrameLimit());
+        starProgram.set(starParams.pointScale, renderScale);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        starCatalog.draw();
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_TEST);
+        
+        glUseProgram(planetProgram.id);
+        objectUniforms.bind(identitySlot);
+
+        // draw orbital paths in white
+        if (drawIndirect) {
+            glUseProgram(planetIndirectProgram.id);
+            planetIndirectProgram.set(planetIndirectParams.objectColor, 1.0f, 1.0f, 1.0f);
+            planetIndirectProgram.set(planetIndirectParams.isSun, false);
+            planetIndirectProgram.set(planetIndirectParams.useTexture, false);
+            planetIndirectProgram.set(planetIndirectParams.isSelected, false);
+            indirect.draw(orbitBatch);
+        } else if (showOrbits) {
+            objectUniforms.bind(identitySlot);
+            planetProgram.set(planetParams.objectColor, 1.0f, 1.0f, 1.0f);
+            planetProgram.set(planetParams.isSun, false);
+            planetProgram.set(planetParams.useTexture, false);
+        
+            // planet orbits are indices 0-7, the moon's orbit (8) sits at earth's position
+            for (uint32_t v : orbitCull.getVisible()) {
+                objectUniforms.bind(v == 8 ? moonOrbitSlot : identitySlot);
+                glBindVertexArray(orbitLines[v].VAO);
+                glDrawArrays(GL_LINE_LOOP, 0, orbitLines[v].vertexCount);
+            }
+        }
+    
+        // traversed paths, all bodies in one multi-draw
+        if (showTrails) {
+            glUseProgram(trailProgram.id);
+            trailProgram.set(trailParams.brightness, 0.8f);
+            trails.draw();
+        }
+    
+        // all celestial bodies and asteroids, one draw per detail level
+        glUseProgram(bodyProgram.id);
+        bodyProgram.set(bodyParams.glowIntensity, glowPulse);
+        surfaceTextures.bind(GL_TEXTURE0);
+        if (drawIndirect) {
+            indirect.draw(sphereBatch);
+        } else {
+            bodyInstances.draw();
+        }
+    
+        // distant ones as ray traced quads, four vertices each
+        if (bodyInstances.getLevelCount(bodyInstances.getImpostorLevel()) > 0) {
+            glUseProgram(bodyImpostorProgram.id);
+            bodyImpostorProgram.set(bodyImpostorParams.glowIntensity, glowPulse);
+            bodyInstances.drawImpostors();
+        }
+    
+        // followed planet close up
+        if (terrainBody >= 0) {
+            glUseProgram(bodyTerrainProgram.id);
+            bodyTerrainProgram.set(bodyTerrainParams.glowIntensity, glowPulse);
+            occlusion.beginConditional(terrainBody);
+            terrain.draw();
+            occlusion.endConditional();
+        }
+        
+        // everything opaque is in the depth buffer, test the boxes for next frame;
+        // the conditional draws below still go by last frame's queries
+        if (!occlusionTests.empty()) {
+            glUseProgram(planetProgram.id);
+            occlusion.beginTests();
+            for (size_t idx : occlusionTests)
+                occlusion.test(idx, proxySlots[idx], objectUniforms);
+            occlusion.endTests();
+        }
+    
+        // ring particles replace the flat ring near saturn (close flybys)
+        float ringOpacity = 1.0f;
+        if (useRingParticles) {
+            saturnRingParticles.update(deltaTime * timeScale, cameraRingLocal);
+        
+            glUseProgram(ringParticleProgram.id);
+            objectUniforms.bind(ringParticleSlot);
+            ringParticleProgram.set(ringParticleParams.innerRadius, saturnRingParticles.innerRadius);
+            ringParticleProgram.set(ringParticleParams.outerRadius, saturnRingParticles.outerRadius);
+            ringParticleProgram.set(ringParticleParams.pointScale, saturn->displayRadius * pixelsPerUnit);
+        
+            if (saturn->ringTextureID != 0) {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, saturn->ringTextureID);
+                ringParticleProgram.set(ringParticleParams.useTexture, true);
+            } else {
+                ringParticleProgram.set(ringParticleParams.useTexture, false);
+                ringParticleProgram.set(ringParticleParams.ringColor, 0.9f, 0.85f, 0.7f);
+            }
+        
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            occlusion.beginConditional(6);
+            saturnRingParticles.draw();
+            occlusion.endConditional();
+            glDisable(GL_PROGRAM_POINT_SIZE);
+        
+            // keep a faint mesh so the far side of the ring doesn't vanish
+            ringOpacity = 0.35f;
+        }
+    
+        // Render planetary rings (Saturn)
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+        if (drawIndirect) {
+            // only saturn has a ring, so its texture serves the whole batch
+            glUseProgram(ringIndirectProgram.id);
+            ringIndirectProgram.set(ringIndirectParams.opacity, ringOpacity);
+            if (saturn->ringTextureID != 0) {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, saturn->ringTextureID);
+                ringIndirectProgram.set(ringIndirectParams.useTexture, true);
+            } else {
+                ringIndirectProgram.set(ringIndirectParams.useTexture, false);
+                ringIndirectProgram.set(ringIndirectParams.ringColor, 0.9f, 0.85f, 0.7f);
+            }
+            occlusion.beginConditional(6);
+            indirect.draw(ringBatch);
+            occlusion.endConditional();
+        } else {
+            glUseProgram(ringProgram.id);
+            ringProgram.set(ringParams.opacity, ringOpacity);
+        
+            glBindVertexArray(ringVAO);
+            for (uint32_t v : ringCull.getVisible()) {
+                size_t idx = ringOwners[v];
+                auto& body = celestialBodies[idx];
+                objectUniforms.bind(ringSlots[idx]);
+            
+                if (body->ringTextureID != 0) {
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, body->ringTextureID);
+                    ringProgram.set(ringParams.useTexture, true);
+                } else {
+                    // Use procedural color for rings
+                    ringProgram.set(ringParams.useTexture, false);
+                    ringProgram.set(ringParams.ringColor, 0.9f, 0.85f, 0.7f);
+                }
+            
+                occlusion.beginConditional(idx);
+                glDrawElements(GL_TRIANGLES, (GLsizei)ring.indices.size(), GL_UNSIGNED_SHORT, 0);
+                occlusion.endConditional();
+            }
+        }
+    
+        // comet tails - additive, no depth writes
+        if (showComets) {
+            double cometUploadStart = glfwGetTime();
+        
+            glBlendFunc(GL_ONE, GL_ONE);
+            glDepthMask(GL_FALSE);
+        
+            glUseProgram(cometProgram.id);
+            cometProgram.set(cometParams.dustSize, 0.35f);
+            cometProgram.set(cometParams.ionSize, 0.2f);
+            cometProgram.set(cometParams.intensity, 0.15f);
+        
+            for (uint32_t v : cometCull.getVisible()) {
+                Comet& comet = comets[v];
+                comet.upload();
+                cometProgram.set(cometParams.ionStart, (int)comet.getIonStart());
+                comet.draw();
+            }
+        
+            glDepthMask(GL_TRUE);
+            cometCpuTime += glfwGetTime() - cometUploadStart;
+        }
+    
+        glDisable(GL_BLEND);
+    }
+};
 
 // Mouse callback
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 std::string loadShaderSource(const char* filePath);
 GLuint compileShader(GLenum type, const char* source);
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
+GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath, const char* defines = "");
 
 // texture loading function
 GLuint loadTexture(const char* path) {
@@ -124,20 +566,45 @@ void createOrbitLine(float radius, GLuint& VAO, GLuint& VBO, int& vertexCount) {
     glBindVertexArray(0);
 }
 
-int main() {
+// a ringed body's ring plane: spun slowly with the body and tilted about 26.7 degrees like
+// Saturn's. the ring mesh and the particle ring both hang off this, unscaled
+glm::mat4 ringFrame(const CelestialBody* body) {
+    glm::mat4 frame = glm::translate(glm::mat4(1.0f), body->position);
+    frame = glm::rotate(frame, body->rotationAngle * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::rotate(frame, glm::radians(26.7f), glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+int main(int argc, char** argv) {
+    // benchmark mode - no window needed
+    bool forceGL33 = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark-spatial") == 0) {
+            runSpatialHashBenchmark();
+            return 0;
+        }
+        if (strcmp(argv[i], "--gl33") == 0) {
+            forceGL33 = true;
+        }
+    }
+    
     // initialize glfw
     if (!glfwInit()) {
         std::cerr << "failed to initialize glfw!" << std::endl;
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 4); // MSAA
     glfwWindowHint(GLFW_DECORATED, GLFW_FALSE); // borderless window
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "solar system simulation", NULL, NULL);
+    // newest context first, 3.3 is the baseline every path supports
+    const int contextVersions[][2] = { {4, 6}, {4, 3}, {3, 3} };
+    GLFWwindow* window = NULL;
+    for (int i = forceGL33 ? 2 : 0; i < 3 && !window; i++) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, contextVersions[i][0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, contextVersions[i][1]);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "solar system simulation", NULL, NULL);
+    }
     if (!window) {
         std::cerr << "failed to create window!" << std::endl;
         glfwTerminate();
@@ -149,6 +616,8 @@ int main() {
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     
     // enable vsync - sync with monitor refresh rate (60hz = 60fps, 144hz = 144fps)
@@ -159,6 +628,11 @@ int main() {
         std::cerr << "failed to initialize glew!" << std::endl;
         return -1;
     }
+    
+    // multi-draw indirect with baseInstance is core in 4.3
+    bool indirectSupported = GLEW_VERSION_4_3 && !forceGL33;
+    std::cout << "opengl " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+    std::cout << "render path: " << (indirectSupported ? "multi-draw indirect" : "gl 3.3") << std::endl;
 
     // initialize imgui
     IMGUI_CHECKVERSION();
@@ -202,18 +676,111 @@ int main() {
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
-
-    // load shader programs
-    GLuint shaderProgram = createShaderProgram("shaders/vertex_shader.glsl", "shaders/fragment_shader.glsl");
-    GLuint blurShader = createShaderProgram("shaders/screen_vertex.glsl", "shaders/blur_shader.glsl");
-    GLuint bloomShader = createShaderProgram("shaders/screen_vertex.glsl", "shaders/bloom_shader.glsl");
-    GLuint ringShader = createShaderProgram("shaders/ring_vertex.glsl", "shaders/ring_fragment.glsl");
-
-    // create sphere geometry
-    Sphere sphere(1.0f, 30, 30);
+    ReversedZ reversedZ;
+    reversedZ.init();
+    std::cout << "depth: reversed-z, " << (reversedZ.isZeroToOne() ? "clip control" : "no clip control") << std::endl;
+
+    // load shader programs, from binaries next to the executable when they're still valid
+    programCache.init((std::filesystem::absolute(argv[0]).parent_path() / "shader_cache").string());
+    ShaderProgram planetProgram(createShaderProgram("shaders/vertex_shader.glsl", "shaders/fragment_shader.glsl"));
+    ShaderProgram bloomDownsampleProgram(createShaderProgram("shaders/screen_vertex.glsl", "shaders/bloom_downsample.glsl"));
+    ShaderProgram bloomUpsampleProgram(createShaderProgram("shaders/screen_vertex.glsl", "shaders/bloom_upsample.glsl"));
+    ShaderProgram bloomProgram(createShaderProgram("shaders/screen_vertex.glsl", "shaders/bloom_shader.glsl"));
+    ShaderProgram ringProgram(createShaderProgram("shaders/ring_vertex.glsl", "shaders/ring_fragment.glsl"));
+    ShaderProgram ringParticleProgram(createShaderProgram("shaders/ring_particle_vertex.glsl", "shaders/ring_particle_fragment.glsl"));
+    ShaderProgram cometProgram(createShaderProgram("shaders/comet_vertex.glsl", "shaders/comet_fragment.glsl"));
+    ShaderProgram trailProgram(createShaderProgram("shaders/trail_vertex.glsl", "shaders/trail_fragment.glsl"));
+    ShaderProgram skyboxProgram(createShaderProgram("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl"));
+    ShaderProgram starProgram(createShaderProgram("shaders/star_vertex.glsl", "shaders/star_fragment.glsl"));
+    ShaderProgram bodyProgram(createShaderProgram("shaders/body_instanced_vertex.glsl", "shaders/body_instanced_fragment.glsl"));
+    ShaderProgram bodyImpostorProgram(createShaderProgram("shaders/body_impostor_vertex.glsl", "shaders/body_instanced_fragment.glsl",
+                                                          reversedZ.isZeroToOne() ? "#define IMPOSTOR\n#define DEPTH_ZERO_TO_ONE\n" : "#define IMPOSTOR\n"));
+    ShaderProgram bodyTerrainProgram(createShaderProgram("shaders/body_instanced_vertex.glsl", "shaders/body_instanced_fragment.glsl", "#define TERRAIN\n"));
     
-    // create ring geometry for saturn
-    Ring ring(1.2f, 2.2f, 100);
+    // same shaders reading the model matrix from per-draw attributes instead of ObjectData
+    ShaderProgram planetIndirectProgram;
+    ShaderProgram ringIndirectProgram;
+    if (indirectSupported) {
+        planetIndirectProgram.reflect(createShaderProgram("shaders/vertex_shader.glsl", "shaders/fragment_shader.glsl", "#define INDIRECT_DRAW\n"));
+        ringIndirectProgram.reflect(createShaderProgram("shaders/ring_vertex.glsl", "shaders/ring_fragment.glsl", "#define INDIRECT_DRAW\n"));
+    }
+    programCache.report();
+    
+    PlanetParams planetParams;
+    planetParams.resolve(planetProgram);
+    BodyParams bodyParams;
+    bodyParams.resolve(bodyProgram);
+    BodyParams bodyImpostorParams;
+    bodyImpostorParams.resolve(bodyImpostorProgram);
+    BodyParams bodyTerrainParams;
+    bodyTerrainParams.resolve(bodyTerrainProgram);
+    PlanetParams planetIndirectParams;
+    RingParams ringIndirectParams;
+    if (indirectSupported) {
+        planetIndirectParams.resolve(planetIndirectProgram);
+        ringIndirectParams.resolve(ringIndirectProgram);
+    }
+    RingParams ringParams;
+    ringParams.resolve(ringProgram);
+    RingParticleParams ringParticleParams;
+    ringParticleParams.resolve(ringParticleProgram);
+    CometParams cometParams;
+    cometParams.resolve(cometProgram);
+    TrailParams trailParams;
+    trailParams.resolve(trailProgram);
+    SkyboxParams skyboxParams;
+    skyboxParams.resolve(skyboxProgram);
+    StarParams starParams;
+    starParams.resolve(starProgram);
+    BloomParams bloomParams;
+    bloomParams.resolve(bloomProgram);
+    
+    // texture units never change, so samplers are set once
+    glUseProgram(planetProgram.id);
+    planetProgram.set(planetProgram.param("textureSampler"), 0);
+    glUseProgram(bodyProgram.id);
+    bodyProgram.set(bodyProgram.param("surfaceTextures"), 0);
+    glUseProgram(bodyImpostorProgram.id);
+    bodyImpostorProgram.set(bodyImpostorProgram.param("surfaceTextures"), 0);
+    glUseProgram(bodyTerrainProgram.id);
+    bodyTerrainProgram.set(bodyTerrainProgram.param("surfaceTextures"), 0);
+    glUseProgram(ringProgram.id);
+    ringProgram.set(ringProgram.param("ringTexture"), 0);
+    glUseProgram(ringParticleProgram.id);
+    ringParticleProgram.set(ringParticleProgram.param("ringTexture"), 0);
+    if (indirectSupported) {
+        glUseProgram(planetIndirectProgram.id);
+        planetIndirectProgram.set(planetIndirectProgram.param("textureSampler"), 0);
+        glUseProgram(ringIndirectProgram.id);
+        ringIndirectProgram.set(ringIndirectProgram.param("ringTexture"), 0);
+    }
+    glUseProgram(skyboxProgram.id);
+    skyboxProgram.set(skyboxProgram.param("skybox"), 0);
+    glUseProgram(bloomProgram.id);
+    bloomProgram.set(bloomProgram.param("scene"), 0);
+    bloomProgram.set(bloomProgram.param("bloomBlur"), 1);
+    glUseProgram(0);
+    
+    // camera/light and per-object matrices live in uniform buffers shared by all programs
+    FrameUniformBuffer frameUniforms;
+    frameUniforms.init();
+    ObjectUniformBuffer objectUniforms;
+    objectUniforms.init();
+
+    // sphere geometry at every detail level, one shared buffer pair
+    SphereLOD sphereLOD;
+    
+    // create ring geometry for saturn - packed positions need unit scale, so the mesh
+    // spans 1.2/2.2 .. 1 and the model matrix scales it back out to 2.2 body radii
+    const float RING_OUTER = 2.2f;
+    Ring ring(1.2f / RING_OUTER, 1.0f, 100);
+    
+    // index order after vertex cache optimization (transformed vertices per triangle)
+    for (const auto& level : sphereLOD.levels) {
+        std::string name = "sphere " + std::to_string(level.rings) + "x" + std::to_string(level.sectors);
+        MeshOptimizer::report(name.c_str(), level.acmrBefore, level.acmrAfter);
+    }
+    MeshOptimizer::report("saturn ring", ring.acmrBefore, ring.acmrAfter);
 
     GLuint VAO, VBO, EBO;
     glGenVertexArrays(1, &VAO);
@@ -223,20 +790,17 @@ int main() {
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sphere.vertices.size() * sizeof(float), sphere.vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sphereLOD.vertices.size() * sizeof(PackedVertex), sphereLOD.vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.indices.size() * sizeof(unsigned int), sphere.indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereLOD.indices.size() * sizeof(uint16_t), sphereLOD.indices.data(), GL_STATIC_DRAW);
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Texture coordinate attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // packed position and uv, normals come from the position
+    setupPackedVertexAttributes();
+    
+    // every sphere in the scene goes through one instanced draw per detail level
+    BodyInstanceRenderer bodyInstances;
+    bodyInstances.init(VBO, EBO, sphereLOD);
     
     // Ring VAO setup
     GLuint ringVAO, ringVBO, ringEBO;
@@ -247,97 +811,22 @@ int main() {
     glBindVertexArray(ringVAO);
     
     glBindBuffer(GL_ARRAY_BUFFER, ringVBO);
-    glBufferData(GL_ARRAY_BUFFER, ring.vertices.size() * sizeof(float), ring.vertices.data(), GL_STATIC_DRAW);
+    std::vector<PackedVertex> ringVertices = packVertices(ring.vertices);
+    glBufferData(GL_ARRAY_BUFFER, ringVertices.size() * sizeof(PackedVertex), ringVertices.data(), GL_STATIC_DRAW);
     
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ringEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, ring.indices.size() * sizeof(unsigned int), ring.indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, ring.indices.size() * sizeof(uint16_t), ring.indices.data(), GL_STATIC_DRAW);
     
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Texture coordinate attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // create starfield - points scattered in distant space
-    std::vector<float> stars;
-    srand(42); // same stars every time
-    for (int i = 0; i < 230; i++) {
-        // spread stars far from origin
-        float x = (rand() % 40000 - 20000) / 10.0f;
-        float y = (rand() % 40000 - 20000) / 10.0f;
-        float z = (rand() % 40000 - 20000) / 10.0f;
-        float brightness = 0.4f + (rand() % 100) / 100.0f * 0.6f;
-        
-        stars.push_back(x);
-        stars.push_back(y);
-        stars.push_back(z);
-        stars.push_back(brightness);
-        stars.push_back(brightness);
-        stars.push_back(brightness);
-    }
+    // packed position and uv, the ring's normal is always up
+    setupPackedVertexAttributes();
 
-    GLuint starsVAO, starsVBO;
-    glGenVertexArrays(1, &starsVAO);
-    glGenBuffers(1, &starsVBO);
-    
-    glBindVertexArray(starsVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, starsVBO);
-    glBufferData(GL_ARRAY_BUFFER, stars.size() * sizeof(float), stars.data(), GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    
-    glPointSize(1.5f);
-
-    // framebuffers for bloom effect
-    GLuint hdrFBO, colorBuffers[2];
+    // hdr scene target, bright parts are picked out of it by the bloom chain; its color and
+    // depth textures come from the pool each frame and are attached when they change
+    RenderTargetPool renderTargets;
+    GLuint hdrFBO;
     glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-    
-    GLuint rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    
-    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
-    
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer error!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    
-    // Ping-pong framebuffers for blur
-    GLuint pingpongFBO[2], pingpongBuffer[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongBuffer);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongBuffer[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongBuffer[i], 0);
-    }
+    GLuint hdrColorAttached = 0, hdrDepthAttached = 0;
+    unsigned int hdrAttachedAllocations = 0;
     
     // Screen quad VAO
     float quadVertices[] = {
@@ -360,6 +849,18 @@ int main() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 
+    BloomChain bloomChain;
+    bloomChain.init(screenWidth, screenHeight, renderTargets, bloomDownsampleProgram, bloomUpsampleProgram);
+    FrameGraph frameGraph(renderTargets);
+    GpuTimer bloomTimer;
+    bloomTimer.init();
+
+    // the 3D scene renders into the lower left renderScale of the hdr target, the composite
+    // stretches it over the window; ui stays at native resolution
+    DynamicResolution dynamicResolution;
+    GpuTimer frameTimer;
+    frameTimer.init();
+
     // solar system setup - using miniature scale for visibility
     celestialBodies.clear();
 
@@ -501,43 +1002,31 @@ int main() {
         std::cout << "  - " << body->name << " (size: " << body->displayRadius << ")" << std::endl;
     }
     
+    // spatial grid over body positions for proximity queries
+    SpatialHash bodyGrid(50.0f);
+    for (size_t i = 0; i < celestialBodies.size(); i++) {
+        bodyGrid.insert((int)i, celestialBodies[i]->position, celestialBodies[i]->displayRadius);
+    }
+    
     // load textures for planets
     std::cout << std::endl;
     std::cout << "loading textures..." << std::endl;
     
-    const char* textureFiles[] = {
-        "textures/sun.jpg",
-        "textures/mercury.jpg",
-        "textures/venus.jpg",
-        "textures/earth.jpg",
-        "textures/mars.jpg",
-        "textures/jupiter.jpg",
-        "textures/saturn.jpg",
-        "textures/uranus.jpg",
-        "textures/neptune.jpg"
-    };
-    
-    for (size_t i = 0; i < celestialBodies.size() && i < 9; i++) {
-        GLuint tex = loadTexture(textureFiles[i]);
-        if (tex != 0) {
-            celestialBodies[i]->textureID = tex;
-            celestialBodies[i]->hasTexture = true;
-        }
-    }
-    
-    // load earth night texture (city lights)
-    GLuint earthNightTexture = loadTexture("textures/earth_night.jpg");
-    if (earthNightTexture != 0) {
-        std::cout << "earth night texture loaded!" << std::endl;
+    // every surface map (and earth's city lights) is a layer of one texture array
+    TextureManager surfaceTextures;
+    for (auto body : celestialBodies) {
+        surfaceTextures.add(body->name, "textures/" + body->name + ".jpg");
     }
+    surfaceTextures.add("earth_night", "textures/earth_night.jpg");
+    surfaceTextures.build();
+    std::cout << "surface texture array: " << surfaceTextures.getLayerCount() << " layers of "
+              << surfaceTextures.getLayerWidth() << "x" << surfaceTextures.getLayerHeight() << std::endl;
     
-    // load moon texture
-    GLuint moonTexture = loadTexture("textures/moon.jpg");
-    if (moonTexture != 0) {
-        celestialBodies[9]->textureID = moonTexture;
-        celestialBodies[9]->hasTexture = true;
-        std::cout << "moon texture loaded!" << std::endl;
+    for (auto body : celestialBodies) {
+        body->textureLayer = surfaceTextures.layer(body->name);
+        body->hasTexture = body->textureLayer >= 0;
     }
+    celestialBodies[3]->nightLayer = surfaceTextures.layer("earth_night");
     
     // Setup Saturn's rings (index 6 is Saturn)
     std::cout << std::endl << "setting up saturn's rings..." << std::endl;
@@ -559,6 +1048,14 @@ int main() {
         std::cout << "saturn ring texture not found, will use procedural rings" << std::endl;
     }
     
+    // particle version of the same ring for close flybys (same local radii as the ring mesh)
+    RingParticleSystem saturnRingParticles(1.2f, 2.2f);
+    if (saturnRingTexture != 0) {
+        saturnRingParticles.loadDensityProfile("textures/saturn_rings.png");
+    }
+    saturnRingParticles.init();
+    std::cout << "saturn ring particle pool: " << saturnRingParticles.getCapacity() << " particles" << std::endl;
+    
     // Load info panel textures for sidebar display
     std::cout << std::endl << "loading info panel textures..." << std::endl;
     
@@ -589,12 +1086,6 @@ int main() {
     // create orbital paths for visualization
     std::cout << std::endl << "creating orbit lines..." << std::endl;
     
-    struct OrbitLine {
-        GLuint VAO, VBO;
-        int vertexCount;
-        float radius;
-    };
-    
     std::vector<OrbitLine> orbitLines;
     
     // orbital radii for planets (indices 1-8, sun is 0)
@@ -615,6 +1106,122 @@ int main() {
     orbitLines.push_back(moonOrbit);
     std::cout << "  - moon orbit created (radius: " << moonOrbit.radius << ")" << std::endl;
     
+    // indirect path keeps sphere, ring and orbit circles in one buffer pair
+    IndirectRenderer indirect;
+    IndirectRenderer::Mesh ringMesh, orbitMesh;
+    std::vector<IndirectRenderer::Mesh> sphereMeshes;
+    if (indirectSupported) {
+        // all levels go in as one mesh, then each level is a slice of it
+        IndirectRenderer::Mesh lodMesh = indirect.addMesh(sphereLOD.vertices, sphereLOD.indices);
+        for (const auto& level : sphereLOD.levels) {
+            IndirectRenderer::Mesh mesh;
+            mesh.firstIndex = lodMesh.firstIndex + level.firstIndex;
+            mesh.indexCount = level.indexCount;
+            mesh.baseVertex = lodMesh.baseVertex + level.baseVertex;
+            sphereMeshes.push_back(mesh);
+        }
+        ringMesh = indirect.addMesh(ringVertices, ring.indices);
+        
+        // same circle as createOrbitLine at unit radius, every orbit scales it in its model matrix
+        std::vector<float> vertices;
+        std::vector<uint16_t> indices;
+        int circleVertices = orbitLines[0].vertexCount;
+        for (int i = 0; i < circleVertices; i++) {
+            float angle = 2.0f * M_PI * i / (circleVertices - 1);
+            float circle[8] = { cosf(angle), 0.0f, sinf(angle), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            vertices.insert(vertices.end(), circle, circle + 8);
+            indices.push_back((uint16_t)i);
+        }
+        orbitMesh = indirect.addMesh(packVertices(vertices), indices);
+        indirect.init();
+    }
+    
+    // traversed-path trails - planets keep about three quarters of an orbit
+    std::vector<unsigned int> trailLengths;
+    for (size_t i = 0; i < celestialBodies.size(); i++) {
+        CelestialBody* body = celestialBodies[i];
+        if (!body->isSun) {
+            float orbitLength = 2.0f * M_PI * (i == 9 ? moonOrbit.radius : body->orbitRadius);
+            body->trailLength = (unsigned int)(orbitLength * 0.75f / TRAIL_SPACING);
+            // the moon's path is traced around the moving earth, keep a bit more of it
+            if (i == 9)
+                body->trailLength = 600;
+        }
+        trailLengths.push_back(body->trailLength);
+    }
+    TrailRenderer trails(TRAIL_SPACING);
+    trails.init(trailLengths);
+    std::cout << "  - trail buffer: " << trails.getTotalVertices() << " vertices" << std::endl;
+    
+    // comets on eccentric orbits, each with its own particle pools
+    std::cout << std::endl << "creating comets..." << std::endl;
+    
+    float billboardCorners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f
+    };
+    GLuint billboardVBO;
+    glGenBuffers(1, &billboardVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, billboardVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(billboardCorners), billboardCorners, GL_STATIC_DRAW);
+    
+    std::vector<Comet> comets;
+    comets.reserve(COMET_COUNT);
+    for (int i = 0; i < COMET_COUNT; i++) {
+        float semiMajorAxis = 150.0f + (rand() % 1000) / 1000.0f * 350.0f;
+        // keep perihelion outside the sun (q = a * (1 - e) >= 25)
+        float maxEccentricity = std::min(0.95f, 1.0f - 25.0f / semiMajorAxis);
+        float eccentricity = 0.7f + (rand() % 1000) / 1000.0f * (maxEccentricity - 0.7f);
+        float inclination = glm::radians((rand() % 1000) / 1000.0f * 40.0f - 20.0f);
+        float ascendingNode = (rand() % 1000) / 1000.0f * 2.0f * M_PI;
+        float argPeriapsis = (rand() % 1000) / 1000.0f * 2.0f * M_PI;
+        float meanAnomaly = (rand() % 1000) / 1000.0f * 2.0f * M_PI;
+        
+        comets.emplace_back(semiMajorAxis, eccentricity, inclination, ascendingNode, argPeriapsis, meanAnomaly, 1234u + i);
+        comets.back().init(billboardVBO);
+    }
+    std::cout << "  - " << comets.size() << " comets created" << std::endl;
+    
+    // main belt, speeds scaled from mars' orbit
+    AsteroidBelt asteroidBelt(ASTEROID_COUNT, 150.0f, 185.0f, 6.0f,
+                              celestialBodies[4]->orbitRadius, celestialBodies[4]->orbitSpeed);
+    std::cout << "  - " << asteroidBelt.getCount() << " asteroids created" << std::endl;
+    int asteroidLayer = surfaceTextures.layer("moon");
+    
+    // object buffer slots, refilled every frame
+    std::vector<int> ringSlots(celestialBodies.size(), -1);
+    std::vector<glm::mat4> ringModels(celestialBodies.size(), glm::mat4(1.0f));
+    std::vector<int> proxySlots(celestialBodies.size(), -1);   // occlusion test boxes
+    
+    OcclusionQueries occlusion;
+    occlusion.init(celestialBodies.size());
+    
+    // bounding spheres tested against the view frustum each frame
+    SphereCullList sphereCull, orbitCull, ringCull, cometCull;
+    sphereCull.reserve(celestialBodies.size() + asteroidBelt.getCount());
+    std::vector<size_t> ringOwners;
+    
+    // detail level each sphere used last frame (-1 = not picked yet), same indexing as sphereCull
+    std::vector<int> sphereLevels(celestialBodies.size() + asteroidBelt.getCount(), -1);
+    const int FIXED_SPHERE_LEVEL = 2;   // used when LOD is off, close to the old 30x30 sphere
+    
+    // quadtree surface for the followed planet once the camera is close, chunks built off-thread
+    const float TERRAIN_RANGE = 20.0f;  // in body radii
+    PlanetTerrain terrain;
+    int terrainWorkers = (int)std::thread::hardware_concurrency() - 1;
+    std::vector<std::string> elevationPaths;
+    for (const auto& body : celestialBodies)
+        elevationPaths.push_back("textures/" + body->name + "_elevation.png");
+    terrain.init(terrainWorkers < 1 ? 1 : (terrainWorkers > 4 ? 4 : terrainWorkers), elevationPaths);
+    
+    // milky way backdrop, converted to a cube map once and cached next to the image
+    Skybox skybox;
+    skybox.init("textures/stars.jpg", "textures/stars.cube");
+    StarCatalog starCatalog;
+    starCatalog.init("textures/star_catalog.bin");
+    
     std::cout << std::endl;
     std::cout << "Controls:" << std::endl;
     std::cout << "  W/A/S/D - Forward/Left/Backward/Right" << std::endl;
@@ -628,11 +1235,19 @@ int main() {
 
     // render loop
     while (!glfwWindowShouldClose(window)) {
+        // minimized, nothing to render into
+        if (screenWidth == 0 || screenHeight == 0) {
+            glfwWaitEvents();
+            lastFrame = static_cast<float>(glfwGetTime());
+            continue;
+        }
+        
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
         processInput(window);
+        uniformStats.reset();
         
         // pulsing glow animation for selected planets
         glowPulse = 0.5f + 0.5f * sin(currentFrame * 3.0f);
@@ -642,7 +1257,7 @@ int main() {
             glm::vec3 planetPos = celestialBodies[selectedPlanetIndex]->position;
             
             // calculate camera position based on yaw and pitch (spherical coordinates)
-            float distance = 80.0f;
+            float distance = glm::max(followDistance, celestialBodies[selectedPlanetIndex]->displayRadius * 1.05f);
             float yaw = glm::radians(camera.Yaw);
             float pitch = glm::radians(camera.Pitch);
             
@@ -699,170 +1314,382 @@ int main() {
             }
         }
         
+        if (showAsteroids) {
+            asteroidBelt.update(deltaTime * timeScale);
+        }
+        
+        // extend the trails, only the newest points get uploaded
+        for (size_t i = 0; i < celestialBodies.size(); i++) {
+            trails.append(i, celestialBodies[i]->position, celestialBodies[i]->color);
+        }
+        trails.upload();
+        
+        // keep the grid in sync, bodies only move in it when they change cell
+        for (size_t i = 0; i < celestialBodies.size(); i++) {
+            bodyGrid.update((int)i, celestialBodies[i]->position);
+        }
+        
+        // slow the camera down when flying close to a surface
+        float nearestSurface = FLT_MAX;
+        int nearestBody = bodyGrid.nearest(camera.Position, &nearestSurface);
+        cameraSpeedFactor = adaptiveCameraSpeed ? glm::clamp(nearestSurface / 60.0f, 0.05f, 1.0f) : 1.0f;
+        
+        // comet orbits and tail particles (cpu time is shown in the menu)
+        double cometTimerStart = glfwGetTime();
+        unsigned int cometParticles = 0;
+        if (showComets) {
+            for (auto& comet : comets) {
+                comet.update(deltaTime * timeScale, celestialBodies[0]->position);
+                cometParticles += comet.getParticleCount();
+            }
+        }
+        double cometCpuTime = glfwGetTime() - cometTimerStart;
+        
         // start imgui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         
-        // HDR framebuffer'a render et
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        float renderScale = dynamicResolution.getScale();
+        int renderWidth = (int)(screenWidth * renderScale + 0.5f);
+        int renderHeight = (int)(screenHeight * renderScale + 0.5f);
+        
+        // targets of the old size are dropped right away, everything else after a few seconds idle
+        renderTargets.beginFrame();
+        if (screenResized) {
+            bloomChain.resize(screenWidth, screenHeight);
+            renderTargets.trim(0);
+            hdrColorAttached = hdrDepthAttached = 0;   // deleted but still attached, the names may come back
+            screenResized = false;
+        } else {
+            renderTargets.trim(300);
+        }
+        skybox.update();   // sky mip levels the loader has finished, a few large faces per frame
+        
+        // saturn's ring frame (the same one its ring mesh uses), also used to decide on the particle ring
+        CelestialBody* saturn = celestialBodies[6];
+        glm::mat4 ringParticleModel = glm::scale(ringFrame(saturn), glm::vec3(saturn->displayRadius));
+        glm::vec3 cameraRingLocal = glm::vec3(glm::inverse(ringParticleModel) * glm::vec4(camera.Position, 1.0f));
+        
+        // depth range fitted to the scene: near is half the clearance to the closest surface
+        // (terrain peaks and saturn's particle ring count as closer), far just reaches the
+        // orbits, bodies and comet tails; sky and stars are drawn at infinity without depth
+        float clearance = nearestSurface;
+        if (terrainEnabled && nearestBody >= 0)
+            clearance -= terrain.heightScale * celestialBodies[nearestBody]->displayRadius;
+        if (ringParticlesEnabled && glm::length(cameraRingLocal) < RING_PARTICLE_DISTANCE)
+            clearance = 0.0f;
+        float nearPlane = glm::clamp(clearance * 0.5f, ReversedZ::MIN_NEAR, MAX_NEAR);
+        float sceneReach = 0.0f;
+        for (const auto& orbit : orbitLines)
+            sceneReach = glm::max(sceneReach, orbit.radius);
+        float farPlane = glm::length(camera.Position) + sceneReach;
+        for (auto body : celestialBodies)
+            farPlane = glm::max(farPlane, glm::length(body->position - camera.Position) + body->displayRadius * RING_OUTER);
+        for (const auto& comet : comets)
+            farPlane = glm::max(farPlane, glm::length(comet.position - camera.Position) + comet.getBoundingRadius());
+        farPlane *= 1.01f;
         
-        // start scene rendering
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);  // Siyah uzay
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         // View/projection transforms
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
-            (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 10000.0f);
+        glm::mat4 projection = reversedZ.perspective(glm::radians(camera.Zoom),
+            (float)screenWidth / (float)screenHeight, nearPlane, farPlane);
         glm::mat4 view = camera.GetViewMatrix();
-
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camera.Position));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(celestialBodies[0]->position));
-
-        // draw background stars
-        glBindVertexArray(starsVAO);
-        glm::mat4 starsModel = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(starsModel));
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 1.0f, 1.0f, 1.0f);
-        glUniform1i(glGetUniformLocation(shaderProgram, "isSun"), true);
-        glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), false);
-        glUniform1i(glGetUniformLocation(shaderProgram, "isSelected"), false);
-        glDrawArrays(GL_POINTS, 0, 3000);
-
-        // draw orbital paths in white
-        if (showOrbits) {
-            glm::mat4 orbitModel = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(orbitModel));
-            glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 1.0f, 1.0f, 1.0f);
-            glUniform1i(glGetUniformLocation(shaderProgram, "isSun"), false);
-            glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), false);
-            
-            // draw planet orbits (indices 0-7)
-            for (int i = 0; i < 8; i++) {
-                glBindVertexArray(orbitLines[i].VAO);
-                glDrawArrays(GL_LINE_LOOP, 0, orbitLines[i].vertexCount);
+        
+        // camera and light for every program, one buffer update
+        FrameData frameData;
+        frameData.view = view;
+        frameData.projection = projection;
+        frameData.viewPos = glm::vec4(camera.Position, currentFrame);
+        frameData.lightPos = glm::vec4(celestialBodies[0]->position, 1.0f);
+        frameUniforms.update(frameData);
+        
+        // model + normal matrices of everything drawn this frame, uploaded together
+        objectUniforms.begin();
+        int identitySlot = objectUniforms.add(glm::mat4(1.0f));
+        int moonOrbitSlot = objectUniforms.add(glm::translate(glm::mat4(1.0f), celestialBodies[3]->position));
+        int ringParticleSlot = objectUniforms.add(ringParticleModel);
+        for (size_t idx = 0; idx < celestialBodies.size(); idx++) {
+            auto& body = celestialBodies[idx];
+            if (body->hasRing) {
+                glm::mat4 ringModel = glm::scale(ringFrame(body), glm::vec3(body->displayRadius * RING_OUTER));
+                ringSlots[idx] = objectUniforms.add(ringModel);
+                ringModels[idx] = ringModel;
+            }
+            // a little larger than the body (and its ring) so its own surface never hides it
+            float proxyRadius = body->displayRadius * (body->hasRing ? RING_OUTER : 1.0f) * 1.05f;
+            proxySlots[idx] = objectUniforms.add(glm::scale(glm::translate(glm::mat4(1.0f), body->position), glm::vec3(proxyRadius)));
+        }
+        objectUniforms.upload();
+        
+        // culling stage - bounding spheres in, compact visible lists out
+        Frustum frustum;
+        frustum.extract(projection * view, reversedZ.isZeroToOne());
+        
+        // catalog stars: sky cells in view, limiting magnitude from the zoom
+        Frustum skyFrustum;
+        skyFrustum.extract(projection * glm::mat4(glm::mat3(view)), reversedZ.isZeroToOne());
+        starCatalog.update(skyFrustum, camera.Zoom);
+        
+        sphereCull.clear();
+        for (auto body : celestialBodies) {
+            sphereCull.add(body->position, body->displayRadius);
+        }
+        if (showAsteroids) {
+            for (size_t i = 0; i < asteroidBelt.getCount(); i++) {
+                sphereCull.add(asteroidBelt.getPosition(i), asteroidBelt.getSize(i));
+            }
+        }
+        
+        // orbits are circles around the sun (moon's around earth)
+        orbitCull.clear();
+        for (int i = 0; i < 8; i++) {
+            orbitCull.add(glm::vec3(0.0f), orbitLines[i].radius);
+        }
+        orbitCull.add(celestialBodies[3]->position, orbitLines[8].radius);
+        
+        ringCull.clear();
+        ringOwners.clear();
+        for (size_t idx = 0; idx < celestialBodies.size(); idx++) {
+            if (celestialBodies[idx]->hasRing) {
+                ringCull.add(celestialBodies[idx]->position, celestialBodies[idx]->displayRadius * RING_OUTER);
+                ringOwners.push_back(idx);
             }
+        }
+        
+        cometCull.clear();
+        for (const auto& comet : comets) {
+            cometCull.add(comet.position, comet.getBoundingRadius());
+        }
+        
+        // the star points surround the camera, so they are never culled
+        SphereCullList* cullLists[] = { &sphereCull, &orbitCull, &ringCull, &cometCull };
+        for (auto list : cullLists) {
+            if (frustumCulling)
+                list->cull(frustum);
+            else
+                list->acceptAll();
+        }
+        
+        bool saturnRingVisible = false;
+        for (uint32_t v : ringCull.getVisible()) {
+            if (ringOwners[v] == 6)
+                saturnRingVisible = true;
+        }
+        
+        float pixelsPerUnit = renderHeight * 0.5f * projection[1][1];
+        
+        // terrain takes over the followed planet inside TERRAIN_RANGE (left a bit further out)
+        int terrainBody = -1;
+        if (terrainEnabled && followMode && selectedPlanetIndex >= 0 && !celestialBodies[selectedPlanetIndex]->isSun) {
+            auto& body = celestialBodies[selectedPlanetIndex];
+            float range = body->displayRadius * TERRAIN_RANGE * (terrain.getBody() == selectedPlanetIndex ? 1.2f : 1.0f);
+            if (glm::length(camera.Position - body->position) < range)
+                terrainBody = selectedPlanetIndex;
+        }
+        terrain.setBody(terrainBody);
+        if (terrainBody >= 0) {
+            auto& body = celestialBodies[terrainBody];
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), body->position);
+            model = glm::rotate(model, body->rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(body->displayRadius));
+            terrain.update(model, camera.Position, frustum, pixelsPerUnit);
+            
+            int nightLayer = body->hasTexture ? body->nightLayer : -1;
+            terrain.setInstance(makeBodyInstance(model, body->color, body->textureLayer, false, true, nightLayer));
             
-            // draw moon's orbit at earth position (index 8)
-            glm::mat4 moonOrbitModel = glm::mat4(1.0f);
-            moonOrbitModel = glm::translate(moonOrbitModel, celestialBodies[3]->position);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(moonOrbitModel));
-            glBindVertexArray(orbitLines[8].VAO);
-            glDrawArrays(GL_LINE_LOOP, 0, orbitLines[8].vertexCount);
+            // plain sphere until the heightmap lookup and the root chunks are done
+            if (!terrain.isReady())
+                terrainBody = -1;
         }
         
-        // render all celestial bodies
-        glBindVertexArray(VAO);
+        // bodies to occlusion test after the opaque draws: on screen, camera outside the box;
+        // the rest are drawn whatever their old result said
+        occlusion.beginFrame();
+        std::vector<size_t> occlusionTests;
+        std::vector<bool> occlusionTested(celestialBodies.size(), false);
+        if (occlusionCulling) {
+            for (uint32_t v : sphereCull.getVisible()) {
+                if (v >= celestialBodies.size())
+                    continue;
+                auto& body = celestialBodies[v];
+                float boxReach = body->displayRadius * (body->hasRing ? RING_OUTER : 1.0f) * 1.05f * 1.7321f;   // box corner
+                if (glm::length(camera.Position - body->position) > boxReach + 0.1f) {
+                    occlusionTests.push_back(v);
+                    occlusionTested[v] = true;
+                }
+            }
+        }
         for (size_t idx = 0; idx < celestialBodies.size(); idx++) {
+            if (!occlusionTested[idx])
+                occlusion.skip(idx);
+        }
+        
+        // visible celestial bodies and asteroids as instances of the LOD spheres,
+        // detail picked from the projected radius in pixels
+        bodyInstances.begin();
+        for (uint32_t v : sphereCull.getVisible()) {
+            if ((int)v == terrainBody)
+                continue;
+            bool isAsteroid = v >= celestialBodies.size();
+            if (!isAsteroid && !occlusion.isVisible(v))
+                continue;   // behind the sun or a planet last frame
+            glm::vec3 center = isAsteroid ? asteroidBelt.getPosition(v - celestialBodies.size()) : celestialBodies[v]->position;
+            float radius = isAsteroid ? asteroidBelt.getSize(v - celestialBodies.size()) : celestialBodies[v]->displayRadius;
+            float distance = glm::length(center - camera.Position);
+            if (distance < radius)
+                distance = radius;   // camera inside the sphere, treat as filling the screen
+            float screenRadius = radius * pixelsPerUnit / distance;
+            
+            int level = FIXED_SPHERE_LEVEL;
+            if (sphereLODEnabled) {
+                level = sphereLOD.select(screenRadius, sphereLevels[v]);
+            }
+            sphereLevels[v] = level;
+            // impostor silhouettes are exact, so switching needs no hysteresis
+            if (impostorsEnabled && screenRadius < impostorPixels) {
+                level = bodyInstances.getImpostorLevel();
+            }
+            
+            if (isAsteroid) {
+                asteroidBelt.addInstance(bodyInstances, v - celestialBodies.size(), asteroidLayer, level);
+                continue;
+            }
+            size_t idx = v;
             auto& body = celestialBodies[idx];
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, body->position);
             model = glm::rotate(model, body->rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
             model = glm::scale(model, glm::vec3(body->displayRadius));
-
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, glm::value_ptr(body->color));
-            glUniform1i(glGetUniformLocation(shaderProgram, "isSun"), body->isSun);
-            glUniform1i(glGetUniformLocation(shaderProgram, "isSelected"), idx == selectedPlanetIndex);
-            glUniform1f(glGetUniformLocation(shaderProgram, "glowIntensity"), glowPulse);
             
-            // apply texture if available
-            if (body->hasTexture) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, body->textureID);
-                glUniform1i(glGetUniformLocation(shaderProgram, "textureSampler"), 0);
-                glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), true);
-                
-                // earth gets special night lights texture
-                if (idx == 3 && earthNightTexture != 0) {
-                    glActiveTexture(GL_TEXTURE1);
-                    glBindTexture(GL_TEXTURE_2D, earthNightTexture);
-                    glUniform1i(glGetUniformLocation(shaderProgram, "nightTexture"), 1);
-                    glUniform1i(glGetUniformLocation(shaderProgram, "hasNightTexture"), true);
-                } else {
-                    glUniform1i(glGetUniformLocation(shaderProgram, "hasNightTexture"), false);
+            int nightLayer = body->hasTexture ? body->nightLayer : -1;
+            bodyInstances.add(model, body->color, body->textureLayer, body->isSun, (int)idx == selectedPlanetIndex, nightLayer, level);
+        }
+        
+        // 4.3+: bodies, orbit lines and rings become three multi-draws
+        bool drawIndirect = indirectSupported && useIndirectDraw;
+        IndirectRenderer::Batch sphereBatch, orbitBatch, ringBatch;
+        if (drawIndirect) {
+            indirect.begin();
+            for (size_t level = 0; level < sphereMeshes.size(); level++) {
+                indirect.addInstanced(sphereMeshes[level], bodyInstances.getInstances((int)level));
+            }
+            sphereBatch = indirect.endBatch(GL_TRIANGLES);
+            
+            if (showOrbits) {
+                for (uint32_t v : orbitCull.getVisible()) {
+                    glm::mat4 orbitModel = v == 8 ? glm::translate(glm::mat4(1.0f), celestialBodies[3]->position) : glm::mat4(1.0f);
+                    orbitModel = glm::scale(orbitModel, glm::vec3(orbitLines[v].radius));
+                    indirect.add(orbitMesh, orbitModel);
                 }
-            } else {
-                glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), false);
-                glUniform1i(glGetUniformLocation(shaderProgram, "hasNightTexture"), false);
             }
-
-            glDrawElements(GL_TRIANGLES, sphere.indices.size(), GL_UNSIGNED_INT, 0);
+            orbitBatch = indirect.endBatch(GL_LINE_LOOP);
+            
+            for (uint32_t v : ringCull.getVisible()) {
+                indirect.add(ringMesh, ringModels[ringOwners[v]]);
+            }
+            ringBatch = indirect.endBatch(GL_TRIANGLES);
+            
+            indirect.upload();
+            bodyInstances.upload(false);
+        } else {
+            bodyInstances.upload();
         }
+
+        // ring particles replace the flat ring near saturn (close flybys)
+        bool useRingParticles = ringParticlesEnabled && saturnRingVisible && glm::length(cameraRingLocal) < RING_PARTICLE_DISTANCE;
         
-        // Render planetary rings (Saturn)
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        
-        glUseProgram(ringShader);
-        glUniformMatrix4fv(glGetUniformLocation(ringShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(ringShader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniform3fv(glGetUniformLocation(ringShader, "viewPos"), 1, glm::value_ptr(camera.Position));
-        glUniform3fv(glGetUniformLocation(ringShader, "lightPos"), 1, glm::value_ptr(celestialBodies[0]->position));
-        
-        glBindVertexArray(ringVAO);
-        for (size_t idx = 0; idx < celestialBodies.size(); idx++) {
-            auto& body = celestialBodies[idx];
-            if (body->hasRing) {
-                glm::mat4 ringModel = glm::mat4(1.0f);
-                ringModel = glm::translate(ringModel, body->position);
-                ringModel = glm::rotate(ringModel, body->rotationAngle * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f));
-                // Tilt the rings slightly (Saturn's rings are tilted about 26.7 degrees)
-                ringModel = glm::rotate(ringModel, glm::radians(26.7f), glm::vec3(1.0f, 0.0f, 0.0f));
-                ringModel = glm::scale(ringModel, glm::vec3(body->displayRadius));
-                
-                glUniformMatrix4fv(glGetUniformLocation(ringShader, "model"), 1, GL_FALSE, glm::value_ptr(ringModel));
-                
-                if (body->ringTextureID != 0) {
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, body->ringTextureID);
-                    glUniform1i(glGetUniformLocation(ringShader, "ringTexture"), 0);
-                    glUniform1i(glGetUniformLocation(ringShader, "useTexture"), true);
-                } else {
-                    // Use procedural color for rings
-                    glUniform1i(glGetUniformLocation(ringShader, "useTexture"), false);
-                    glUniform3f(glGetUniformLocation(ringShader, "ringColor"), 0.9f, 0.85f, 0.7f);
-                }
-                
-                glDrawElements(GL_TRIANGLES, ring.indices.size(), GL_UNSIGNED_INT, 0);
+        // glow from everything over the threshold; only the sun gets there, so the passes are
+        // limited to its rectangle and culled when it is off screen or behind a planet
+        const CelestialBody* sun = celestialBodies[0];
+        bool sunGlows = bloomStrength > 0.0f && frustum.containsSphere(sun->position, sun->displayRadius) && occlusion.isVisible(0);
+        glm::vec3 toSun = sun->position - camera.Position;
+        float sunDistance = glm::length(toSun);
+        if (sunGlows && sunDistance > sun->displayRadius) {
+            float sunAngle = asinf(sun->displayRadius / sunDistance);
+            for (size_t i = 1; i < celestialBodies.size() && sunGlows; i++) {
+                glm::vec3 toBody = celestialBodies[i]->position - camera.Position;
+                float bodyDistance = glm::length(toBody);
+                float radius = celestialBodies[i]->displayRadius;
+                if (bodyDistance <= radius || bodyDistance >= sunDistance)
+                    continue;
+                float apart = acosf(glm::clamp(glm::dot(toBody, toSun) / (bodyDistance * sunDistance), -1.0f, 1.0f));
+                if (apart + sunAngle <= asinf(radius / bodyDistance))
+                    sunGlows = false;
             }
         }
+        glm::ivec4 glowArea(0, 0, renderWidth, renderHeight);
+        if (sunGlows && sphereScreenRect(projection * view, sun->position, sun->displayRadius, renderWidth, renderHeight, glowArea)) {
+            int reach = bloomChain.getReach();
+            glowArea += glm::ivec4(-reach, -reach, 2 * reach, 2 * reach);
+        }
         
-        glDisable(GL_BLEND);
+        // the frame's passes; pool targets are only held between their first and last use
+        frameGraph.reset();
+        glm::ivec2 bloomSize = bloomChain.getResultSize();
+        int sceneColor = frameGraph.createTexture("scene color", GL_RGBA16F, screenWidth, screenHeight);
+        int sceneDepth = frameGraph.createTexture("scene depth", GL_DEPTH_COMPONENT32F, screenWidth, screenHeight);
+        int bloomColor = frameGraph.createTexture("bloom", GL_RGBA16F, bloomSize.x, bloomSize.y);
+        int backbuffer = frameGraph.importResource("backbuffer");
+        frameGraph.markOutput(backbuffer);
+        
+        // scene into the HDR targets
+        ScenePass scene = {
+            frameGraph, renderTargets, sceneColor, sceneDepth,
+            hdrFBO, hdrColorAttached, hdrDepthAttached, hdrAttachedAllocations,
+            renderWidth, renderHeight, renderScale, pixelsPerUnit, drawIndirect, terrainBody, useRingParticles, cameraRingLocal,
+            skyboxProgram, skyboxParams, starProgram, starParams,
+            planetProgram, planetParams, planetIndirectProgram, planetIndirectParams,
+            trailProgram, trailParams,
+            bodyProgram, bodyParams, bodyImpostorProgram, bodyImpostorParams, bodyTerrainProgram, bodyTerrainParams,
+            ringParticleProgram, ringParticleParams, ringProgram, ringParams, ringIndirectProgram, ringIndirectParams,
+            cometProgram, cometParams,
+            objectUniforms, identitySlot, moonOrbitSlot, ringParticleSlot, proxySlots, ringSlots,
+            indirect, sphereBatch, orbitBatch, ringBatch,
+            orbitCull, ringCull, cometCull, ringOwners, occlusionTests,
+            skybox, starCatalog, orbitLines, trails, surfaceTextures, bodyInstances, terrain, occlusion,
+            saturnRingParticles, saturn, ringVAO, ring, comets, cometCpuTime,
+        };
+        int scenePass = frameGraph.addPass("scene", [&]() { scene.draw(); });
+        frameGraph.write(scenePass, sceneColor);
+        frameGraph.write(scenePass, sceneDepth);   // nothing reads depth after the scene, so it goes straight back
+        
+        int bloomPass = frameGraph.addPass("bloom", [&]() {
+            bloomTimer.begin();
+            bloomChain.render(frameGraph.getTexture(sceneColor), quadVAO, glowArea, glm::ivec2(renderWidth, renderHeight),
+                              frameGraph.getTarget(bloomColor));
+            bloomTimer.end();
+        });
+        frameGraph.read(bloomPass, sceneColor);
+        frameGraph.write(bloomPass, bloomColor);
         
-        // apply gaussian blur passes
-        bool horizontal = true, first_iteration = true;
-        int amount = 4;  // reduced from 10 for performance
-        glUseProgram(blurShader);
-        for (unsigned int i = 0; i < amount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            glUniform1i(glGetUniformLocation(blurShader, "horizontal"), horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongBuffer[!horizontal]);
+        // final render pass with bloom effect
+        int compositePass = frameGraph.addPass("composite", [&]() {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, screenWidth, screenHeight);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(bloomProgram.id);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, frameGraph.getTexture(sceneColor));
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, sunGlows ? frameGraph.getTexture(bloomColor) : 0);
+            glActiveTexture(GL_TEXTURE0);
+            bloomProgram.set(bloomParams.bloom, sunGlows ? bloomStrength : 0.0f);
+            bloomProgram.set(bloomParams.exposure, 1.0f);
+            bloomProgram.set(bloomParams.sceneScale, glm::vec2((float)renderWidth / screenWidth, (float)renderHeight / screenHeight));
+            bloomProgram.set(bloomParams.bloomScale, bloomChain.getScale());
             glBindVertexArray(quadVAO);
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        });
+        frameGraph.read(compositePass, sceneColor);
+        if (sunGlows)
+            frameGraph.read(compositePass, bloomColor);   // without this reader the bloom pass is culled
+        frameGraph.write(compositePass, backbuffer);
         
-        // final render pass with bloom effect
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(bloomShader);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongBuffer[!horizontal]);
-        glUniform1i(glGetUniformLocation(bloomShader, "scene"), 0);
-        glUniform1i(glGetUniformLocation(bloomShader, "bloomBlur"), 1);
-        glUniform1f(glGetUniformLocation(bloomShader, "bloom"), 0.3f);  // reduced from 1.0 to 0.3 for less bloom
-        glUniform1f(glGetUniformLocation(bloomShader, "exposure"), 1.0f);
-        glBindVertexArray(quadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        frameGraph.compile();
+        frameTimer.begin();
+        frameGraph.execute();
+        frameTimer.end();
+        dynamicResolution.update(frameTimer.getMilliseconds());
         
         // show ui menu after bloom rendering
         if (showMenu) {
@@ -890,6 +1717,11 @@ int main() {
             ImGui::SliderFloat("##cameraspeed", &camera.MovementSpeed, 10.0f, 200.0f, "camera speed: %.0f");
             ImGui::PopItemWidth();
             
+            ImGui::Checkbox("slow down near surfaces", &adaptiveCameraSpeed);
+            if (nearestBody >= 0) {
+                ImGui::Text("nearest: %s (%.0f units)", celestialBodies[nearestBody]->name.c_str(), nearestSurface);
+            }
+            
             ImGui::Spacing();
             ImGui::Separator();
             ImGui::Spacing();
@@ -899,6 +1731,24 @@ int main() {
             ImGui::Spacing();
             
             ImGui::Checkbox("show orbit lines", &showOrbits);
+            ImGui::Checkbox("show trails", &showTrails);
+            ImGui::Checkbox("ring particles on close flyby", &ringParticlesEnabled);
+            if (useRingParticles) {
+                ImGui::Text("ring particles: %u", saturnRingParticles.getActiveParticles());
+            }
+            ImGui::Checkbox("show asteroid belt", &showAsteroids);
+            ImGui::Checkbox("show comets", &showComets);
+            ImGui::SliderFloat("sun glow", &bloomStrength, 0.0f, 1.0f, "%.2f");
+            ImGui::SliderFloat("sky brightness", &skyBrightness, 0.0f, 2.0f, "%.2f");
+            ImGui::SliderFloat("star limit", &starCatalog.limitMagnitude, 2.0f, 10.0f, "mag %.1f");
+            ImGui::Text("stars: %zu of %zu drawn (to mag %.1f, %zu cells)", starCatalog.getDrawnStars(),
+                        starCatalog.getStarCount(), starCatalog.getFrameLimit(), starCatalog.getVisibleCells());
+            if (!skybox.isReady() || skybox.getResidentSize() < skybox.getFaceSize()) {
+                ImGui::Text("sky: %d of %d per face loaded", skybox.getResidentSize(), skybox.getFaceSize());
+            }
+            if (showComets) {
+                ImGui::Text("comet particles: %u (%.2f ms cpu)", cometParticles, cometCpuTime * 1000.0);
+            }
             
             ImGui::Spacing();
             ImGui::Separator();
@@ -913,6 +1763,17 @@ int main() {
                 
                 ImGui::Spacing();
                 ImGui::Checkbox("follow mode", &followMode);
+                
+                CelestialBody* selected = celestialBodies[selectedPlanetIndex];
+                if (!selected->isSun) {
+                    int trailLength = (int)selected->trailLength;
+                    ImGui::PushItemWidth(-1);
+                    if (ImGui::SliderInt("##traillength", &trailLength, 0, 4000, "trail length: %d")) {
+                        selected->trailLength = (unsigned int)trailLength;
+                        trails.setCapacity(selectedPlanetIndex, selected->trailLength);
+                    }
+                    ImGui::PopItemWidth();
+                }
                 ImGui::Spacing();
                 
                 if (ImGui::Button("clear selection", ImVec2(-1, 0))) {
@@ -931,6 +1792,66 @@ int main() {
             
             // info section
             ImGui::Text("fps: %.0f", ImGui::GetIO().Framerate);
+            ImGui::Text("uniform uploads: %u (skipped %u unchanged, %u name lookups saved)",
+                        uniformStats.uploads, uniformStats.redundantSkipped, uniformStats.lookupsAvoided);
+            ImGui::Text("object uniform slots: %u (one upload)", objectUniforms.getCount());
+            ImGui::Text("sphere instances: %zu (one draw per level)", bodyInstances.getCount());
+            ImGui::Checkbox("sphere LOD", &sphereLODEnabled);
+            // instances per mesh level (by ring count), then the impostor bucket
+            std::string lodText = "LOD rings:";
+            for (int level = 0; level < bodyInstances.getImpostorLevel(); level++) {
+                lodText += " " + std::to_string(bodyInstances.getLevelRings(level)) + "=" +
+                           std::to_string(bodyInstances.getLevelCount(level));
+            }
+            lodText += ", impostors=" + std::to_string(bodyInstances.getLevelCount(bodyInstances.getImpostorLevel()));
+            ImGui::TextUnformatted(lodText.c_str());
+            ImGui::Checkbox("impostors", &impostorsEnabled);
+            ImGui::SameLine();
+            ImGui::SliderFloat("below px", &impostorPixels, 1.0f, 200.0f, "%.0f");
+            ImGui::Text("sphere triangles: %zu", bodyInstances.getTriangleCount());
+            ImGui::Checkbox("planet terrain", &terrainEnabled);
+            ImGui::SameLine();
+            ImGui::SliderFloat("px error", &terrain.pixelError, 1.0f, 32.0f, "%.0f");
+            if (terrain.getBody() >= 0) {
+                ImGui::Text("terrain: %zu chunks, %zu tris, %d/%d resident, %d building%s",
+                            terrain.getDrawnChunks(), terrain.getTriangleCount(), terrain.getResidentChunks(),
+                            PlanetTerrain::SLOT_COUNT, terrain.getPendingChunks(), terrain.hasHeightmap() ? "" : " (flat)");
+            }
+            if (sunGlows) {
+                const glm::ivec4& glow = bloomChain.getRegion();
+                ImGui::Text("bloom: %.2f ms gpu (%d levels, %dx%d of %dx%d)", bloomTimer.getMilliseconds(),
+                            bloomChain.getLevelCount(), glow.z, glow.w, renderWidth, renderHeight);
+            } else {
+                ImGui::Text("bloom: culled (sun hidden)");
+            }
+            ImGui::Text("passes: %s", frameGraph.describe().c_str());
+            ImGui::Text("render targets: %d textures, %.1f MB (%d/%d acquires reused a texture this frame)",
+                        renderTargets.getCount(), renderTargets.getBytes() / (1024.0 * 1024.0),
+                        renderTargets.getFrameReuses(), renderTargets.getFrameAcquires());
+            ImGui::Checkbox("dynamic resolution", &dynamicResolution.enabled);
+            ImGui::SameLine();
+            ImGui::SliderFloat("gpu ms", &dynamicResolution.budgetMs, 4.0f, 33.0f, "%.1f");
+            ImGui::Text("scene: %dx%d (%.0f%%), %.2f ms gpu", renderWidth, renderHeight, renderScale * 100.0f,
+                        frameTimer.getMilliseconds());
+            ImGui::Text("depth: %.5f .. %.0f (reversed-z%s)", nearPlane, farPlane,
+                        reversedZ.isZeroToOne() ? "" : ", no clip control");
+            ImGui::Checkbox("frustum culling", &frustumCulling);
+            ImGui::SameLine();
+            ImGui::Checkbox("occlusion queries", &occlusionCulling);
+            ImGui::Text("occlusion: %zu bodies tested, %d hidden", occlusionTests.size(), occlusion.getHiddenCount());
+            ImGui::Text("spheres: %zu drawn, %zu culled", sphereCull.getVisible().size(), sphereCull.getCulledCount());
+            ImGui::Text("orbits %zu/%zu  rings %zu/%zu  comets %zu/%zu",
+                        orbitCull.getVisible().size(), orbitCull.getCount(),
+                        ringCull.getVisible().size(), ringCull.getCount(),
+                        cometCull.getVisible().size(), cometCull.getCount());
+            if (indirectSupported) {
+                ImGui::Checkbox("multi-draw indirect", &useIndirectDraw);
+                if (drawIndirect) {
+                    ImGui::Text("indirect commands: %u in 3 calls", indirect.getCommandCount());
+                }
+            } else {
+                ImGui::Text("render path: gl 3.3");
+            }
             
             ImGui::Spacing();
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
@@ -956,7 +1877,7 @@ int main() {
             // sidebar positioning on the right side
             float sidebarWidth = 380.0f;
             float sidebarHeight = 650.0f;
-            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH - sidebarWidth - 20, (SCR_HEIGHT - sidebarHeight) / 2), ImGuiCond_Always);
+            ImGui::SetNextWindowPos(ImVec2(screenWidth - sidebarWidth - 20, (screenHeight - sidebarHeight) / 2), ImGuiCond_Always);
             ImGui::SetNextWindowSize(ImVec2(sidebarWidth, sidebarHeight), ImGuiCond_Always);
             
             ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 15.0f);
@@ -993,16 +1914,12 @@ int main() {
             ImGui::Spacing();
             
             // planet texture preview with border
-            // Use info texture if available, otherwise fallback to regular texture
-            bool hasDisplayTexture = selectedPlanet->hasInfoTexture || selectedPlanet->hasTexture;
-            if (hasDisplayTexture) {
+            // surface maps live in a texture array, so only the info texture can be shown
+            if (selectedPlanet->hasInfoTexture) {
                 float imageSize = 180.0f;
                 ImGui::SetCursorPosX((sidebarWidth - imageSize) * 0.5f);
                 
-                GLuint displayTexture = selectedPlanet->hasInfoTexture ? 
-                    selectedPlanet->infoTextureID : selectedPlanet->textureID;
-                    
-                ImGui::Image((void*)(intptr_t)displayTexture, 
+                ImGui::Image((void*)(intptr_t)selectedPlanet->infoTextureID, 
                        ImVec2(imageSize, imageSize));
             }
             
@@ -1115,7 +2032,7 @@ int main() {
         
         // draw crosshair when not in menu
         if (!showMenu) {
-            ImGui::SetNextWindowPos(ImVec2(SCR_WIDTH / 2.0f - 20, SCR_HEIGHT / 2.0f - 20));
+            ImGui::SetNextWindowPos(ImVec2(screenWidth / 2.0f - 20, screenHeight / 2.0f - 20));
             ImGui::SetNextWindowSize(ImVec2(40, 40));
             ImGui::Begin("Crosshair", nullptr, 
                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | 
@@ -1123,7 +2040,7 @@ int main() {
                 ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoInputs);
             
             ImDrawList* draw_list = ImGui::GetWindowDrawList();
-            ImVec2 center(SCR_WIDTH / 2.0f, SCR_HEIGHT / 2.0f);
+            ImVec2 center(screenWidth / 2.0f, screenHeight / 2.0f);
             
             // draw crosshair
             draw_list->AddLine(
@@ -1150,7 +2067,7 @@ int main() {
         }
         
         // Credit text - always visible, no background box
-        ImGui::SetNextWindowPos(ImVec2(20, SCR_HEIGHT - 50), ImGuiCond_Always);
+        ImGui::SetNextWindowPos(ImVec2(20, screenHeight - 50), ImGuiCond_Always);
         ImGui::SetNextWindowBgAlpha(0.0f); // completely transparent background
         ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f); // no border
         ImGui::Begin("CreditText", nullptr,
@@ -1182,6 +2099,21 @@ int main() {
         delete body;
     }
     
+    saturnRingParticles.destroy();
+    for (auto& comet : comets) {
+        comet.destroy();
+    }
+    trails.destroy();
+    bodyInstances.destroy();
+    terrain.destroy();
+    skybox.destroy();
+    starCatalog.destroy();
+    indirect.destroy();
+    occlusion.destroy();
+    frameUniforms.destroy();
+    objectUniforms.destroy();
+    glDeleteBuffers(1, &billboardVBO);
+    
     // free orbit line resources
     for (auto& orbit : orbitLines) {
         glDeleteVertexArrays(1, &orbit.VAO);
@@ -1191,15 +2123,30 @@ int main() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
-    glDeleteVertexArrays(1, &starsVAO);
-    glDeleteBuffers(1, &starsVBO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
     glDeleteFramebuffers(1, &hdrFBO);
-    glDeleteFramebuffers(2, pingpongFBO);
-    glDeleteProgram(shaderProgram);
-    glDeleteProgram(blurShader);
-    glDeleteProgram(bloomShader);
+    bloomChain.destroy();
+    renderTargets.destroy();
+    bloomTimer.destroy();
+    frameTimer.destroy();
+    glDeleteProgram(planetProgram.id);
+    glDeleteProgram(bloomDownsampleProgram.id);
+    glDeleteProgram(bloomUpsampleProgram.id);
+    glDeleteProgram(bloomProgram.id);
+    glDeleteProgram(ringParticleProgram.id);
+    glDeleteProgram(cometProgram.id);
+    glDeleteProgram(trailProgram.id);
+    glDeleteProgram(skyboxProgram.id);
+    glDeleteProgram(starProgram.id);
+    glDeleteProgram(bodyProgram.id);
+    glDeleteProgram(bodyImpostorProgram.id);
+    glDeleteProgram(bodyTerrainProgram.id);
+    if (indirectSupported) {
+        glDeleteProgram(planetIndirectProgram.id);
+        glDeleteProgram(ringIndirectProgram.id);
+    }
+    surfaceTextures.destroy();
 
     glfwTerminate();
     return 0;
@@ -1211,20 +2158,26 @@ void processInput(GLFWwindow* window) {
 
     if (!showMenu) {  // no camera movement when menu is open
         if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            camera.ProcessKeyboard(FORWARD, deltaTime);
+            camera.ProcessKeyboard(FORWARD, deltaTime * cameraSpeedFactor);
         if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            camera.ProcessKeyboard(BACKWARD, deltaTime);
+            camera.ProcessKeyboard(BACKWARD, deltaTime * cameraSpeedFactor);
         if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            camera.ProcessKeyboard(LEFT, deltaTime);
+            camera.ProcessKeyboard(LEFT, deltaTime * cameraSpeedFactor);
         if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            camera.ProcessKeyboard(RIGHT, deltaTime);
+            camera.ProcessKeyboard(RIGHT, deltaTime * cameraSpeedFactor);
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-            camera.ProcessKeyboard(UP, deltaTime);
+            camera.ProcessKeyboard(UP, deltaTime * cameraSpeedFactor);
         if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-            camera.ProcessKeyboard(DOWN, deltaTime);
+            camera.ProcessKeyboard(DOWN, deltaTime * cameraSpeedFactor);
     }
 }
 
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    screenWidth = width;
+    screenHeight = height;
+    screenResized = true;
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_TAB && action == GLFW_PRESS) {
         showMenu = !showMenu;
@@ -1253,18 +2206,18 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         if (showMenu) return;
         
         // use screen center when cursor is disabled
-        float xpos = SCR_WIDTH / 2.0f;
-        float ypos = SCR_HEIGHT / 2.0f;
+        float xpos = screenWidth / 2.0f;
+        float ypos = screenHeight / 2.0f;
         
         // convert screen position to normalized device coordinates
-        float x = (2.0f * xpos) / SCR_WIDTH - 1.0f;
-        float y = 1.0f - (2.0f * ypos) / SCR_HEIGHT;
+        float x = (2.0f * xpos) / screenWidth - 1.0f;
+        float y = 1.0f - (2.0f * ypos) / screenHeight;
         
         glm::vec4 rayClip(x, y, -1.0, 1.0);
         
         // View space'e
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
-            (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 10000.0f);
+            (float)screenWidth / (float)screenHeight, 0.1f, 10000.0f);
         glm::vec4 rayEye = glm::inverse(projection) * rayClip;
         rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0, 0.0);
         
@@ -1298,6 +2251,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         if (closestIndex != -1) {
             selectedPlanetIndex = closestIndex;
             followMode = true;  // automatically enable follow mode
+            followDistance = 80.0f;
             std::cout << "selected planet: " << celestialBodies[closestIndex]->name << " - follow mode enabled" << std::endl;
         }
     }
@@ -1333,17 +2287,43 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     if (showMenu) return; // no zoom when menu is open
+    
+    // following a planet, scroll moves the camera in and out instead (down to low orbit)
+    if (followMode && selectedPlanetIndex >= 0 && selectedPlanetIndex < celestialBodies.size()) {
+        float minDistance = celestialBodies[selectedPlanetIndex]->displayRadius * 1.05f;
+        followDistance = glm::clamp(followDistance * powf(0.85f, static_cast<float>(yoffset)), minDistance, 400.0f);
+        return;
+    }
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
+// #include "file" lines are replaced by that file (relative to the including shader), so
+// blocks shared by many shaders like FrameData live in one place
 std::string loadShaderSource(const char* filePath) {
     std::ifstream file(filePath);
     if (!file.is_open()) {
         std::cerr << "Shader dosyası açılamadı: " << filePath << std::endl;
         return "";
     }
+    std::string directory = filePath;
+    size_t slash = directory.find_last_of("/\\");
+    directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
     std::stringstream buffer;
-    buffer << file.rdbuf();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t open = line.find('"');
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (line.compare(0, 8, "#include") == 0 && close != std::string::npos) {
+            std::string included = directory + line.substr(open + 1, close - open - 1);
+            // error messages keep pointing at the right line of this file
+            buffer << loadShaderSource(included.c_str()) << "#line " << lineNumber + 1 << "\n";
+        } else {
+            buffer << line << "\n";
+        }
+    }
     return buffer.str();
 }
 
@@ -1362,16 +2342,35 @@ GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
+// defines go right after the #version line
+std::string injectDefines(const std::string& source, const char* defines) {
+    if (defines == NULL || defines[0] == '\0')
+        return source;
+    size_t lineEnd = source.find('\n');
+    if (lineEnd == std::string::npos)
+        return source;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath, const char* defines) {
+    std::string vertexCode = injectDefines(loadShaderSource(vertexPath), defines);
+    std::string fragmentCode = injectDefines(loadShaderSource(fragmentPath), defines);
 
+    // same paths and defines share a cache entry, the source hash says whether it's current
+    std::string cacheName = std::string(vertexPath) + "|" + fragmentPath + "|" + defines;
+    uint64_t sourceHash = ProgramCache::hash(vertexCode + '\0' + fragmentCode);
+    GLuint cached = programCache.load(cacheName, sourceHash);
+    if (cached != 0)
+        return cached;
+
+    double compileStart = glfwGetTime();
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str());
     GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
 
     GLuint program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+    programCache.prepare(program);
     glLinkProgram(program);
 
     int success;
@@ -1380,6 +2379,8 @@ GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
     if (!success) {
         glGetProgramInfoLog(program, 512, NULL, infoLog);
         std::cerr << "Program bağlama hatası:\n" << infoLog << std::endl;
+    } else {
+        programCache.store(cacheName, sourceHash, program, (glfwGetTime() - compileStart) * 1000.0);
     }
 
     glDeleteShader(vertexShader);